@@ -0,0 +1,347 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dictionary/dictionary.hpp"
+#include "layout/layout.hpp"
+#include "rope/builder.hpp"
+#include "rope/rope.hpp"
+#include "search/search.hpp"
+
+// Headless benchmarks of the engines under the editor: rope edits and
+// index conversions, search, the dictionary and the layout. Every case
+// reports the time and the heap allocations per operation, to the console
+// and as JSON to the file given with --output (bench.json by default), so
+// runs of different versions can be compared.
+
+namespace {
+    std::atomic< std::size_t > allocations{0};
+    std::atomic< std::size_t > allocatedBytes{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    std::size_t ops;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+std::vector< Result > results;
+
+// Runs body(i) for i in [0, ops) and records the cost per call
+template < typename Body >
+void run(const std::string& name, std::size_t ops, Body&& body) {
+    std::size_t allocsBefore = allocations.load();
+    std::size_t bytesBefore = allocatedBytes.load();
+    Clock::time_point start = Clock::now();
+
+    for (std::size_t i = 0; i < ops; ++i) body(i);
+
+    double ns =
+        std::chrono::duration< double, std::nano >(Clock::now() - start)
+            .count();
+    Result result{name, ops, ns / ops,
+                  double(allocations.load() - allocsBefore) / ops,
+                  double(allocatedBytes.load() - bytesBefore) / ops};
+    results.push_back(result);
+
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::setw(10) << ops << std::setw(14) << std::fixed
+              << std::setprecision(1) << result.nsPerOp << std::setw(12)
+              << result.allocsPerOp << std::setw(14) << result.bytesPerOp
+              << std::endl;
+}
+
+// Text of words and lines, like prose
+nstring prose(std::mt19937& rng, std::size_t length) {
+    static const char* words[] = {"the",    "editor", "rope",  "of",
+                                  "and",    "a",      "line",  "text",
+                                  "search", "word",   "cursor"};
+    std::string text;
+    text.reserve(length + 16);
+    while (text.size() < length) {
+        text += words[rng() % 11];
+        text += rng() % 12 ? ' ' : '\n';
+    }
+    text.resize(length);
+    return nstring(text);
+}
+
+Rope build(const nstring& text) {
+    rope::Builder builder;
+    builder.append(text);
+    return builder.build();
+}
+
+void benchRope() {
+    std::mt19937 rng(2024);
+    nstring text = prose(rng, 1 << 20);
+    Rope base = build(text);
+
+    // the document rebalances after every edit
+    auto keep = [](Rope& rope, Rope edited) {
+        rope = edited.is_balanced() ? edited : edited.rebalance();
+    };
+
+    Rope rope = base;
+    std::size_t pos = rope.length() / 2;
+    run("rope/insert/sequential", 100000, [&](std::size_t) {
+        keep(rope, rope.insert(pos++, nstring("x")));
+    });
+
+    rope = base;
+    run("rope/insert/random", 20000, [&](std::size_t) {
+        keep(rope, rope.insert(rng() % rope.length(), nstring("x")));
+    });
+
+    rope = base;
+    pos = rope.length() / 2;
+    run("rope/erase/sequential", 100000, [&](std::size_t) {
+        keep(rope, rope.erase(--pos, 1));
+    });
+
+    rope = base;
+    run("rope/erase/random", 20000, [&](std::size_t) {
+        keep(rope, rope.erase(rng() % (rope.length() - 1), 1));
+    });
+
+    std::size_t sink = 0;
+    run("rope/split/random", 100000, [&](std::size_t) {
+        sink += base.split(rng() % base.length()).first.length();
+    });
+
+    run("rope/subnstr/random", 100000, [&](std::size_t) {
+        sink += base.subnstr(rng() % (base.length() - 100), 100).length();
+    });
+
+    std::size_t lines = base.line_count();
+    run("rope/pos_from_index/random", 100000, [&](std::size_t) {
+        sink += base.pos_from_index(rng() % base.length()).first;
+    });
+
+    run("rope/index_from_pos/random", 100000, [&](std::size_t) {
+        sink += base.index_from_pos(rng() % lines, 0);
+    });
+
+    run("rope/line_length/random", 100000, [&](std::size_t) {
+        sink += base.line_length(rng() % lines);
+    });
+
+    run("rope/build/1M", 10,
+        [&](std::size_t) { sink += build(text).length(); });
+
+    if (sink == 0) std::cout << std::endl;
+}
+
+void benchSearch() {
+    std::mt19937 rng(7);
+    Rope corpus = build(prose(rng, 1 << 20));
+    Rope repetitive = build(nstring(std::string(1 << 20, 'a')));
+
+    Search search;
+    std::size_t matches = 0;
+
+    search.set_pattern(Rope(nstring("cursor")));
+    run("search/find/prose", 5, [&](std::size_t) {
+        search.find_in_content(corpus);
+        matches += search.match_idx().size();
+    });
+
+    // every position is a near match
+    search.set_pattern(Rope(nstring(std::string(32, 'a') + "b")));
+    run("search/find/repetitive", 5, [&](std::size_t) {
+        search.find_in_content(repetitive);
+        matches += search.match_idx().size();
+    });
+
+    search.set_pattern(Rope(nstring("word")));
+    search.set_replacement(Rope(nstring("term")));
+    run("search/replace/prose", 5, [&](std::size_t) {
+        matches += search.replace_in_content(corpus).length();
+    });
+
+    if (matches == 0) std::cout << std::endl;
+}
+
+void benchDictionary() {
+    // a word list of pseudo-words, the real one is not part of the sources
+    std::mt19937 rng(11);
+    std::vector< std::string > words;
+    for (std::size_t i = 0; i < 50000; ++i) {
+        std::string word;
+        std::size_t length = 3 + rng() % 8;
+        for (std::size_t j = 0; j < length; ++j) word += 'a' + rng() % 26;
+        words.push_back(word);
+    }
+
+    std::string path =
+        (std::filesystem::temp_directory_path() / "bench_words.txt").string();
+    {
+        std::ofstream file(path);
+        for (const auto& word : words) file << word << '\n';
+    }
+
+    Dictionary dictionary;
+    run("dictionary/load/50k", 1,
+        [&](std::size_t) { dictionary.loadDatabase(path); });
+    std::filesystem::remove(path);
+
+    std::size_t found = 0;
+    run("dictionary/search/hit", 100000, [&](std::size_t) {
+        found += dictionary.search(nstring(words[rng() % words.size()]));
+    });
+
+    run("dictionary/search/miss", 100000, [&](std::size_t) {
+        found += dictionary.search(nstring("zq" + words[rng() % words.size()]));
+    });
+
+    run("dictionary/suggest", 20, [&](std::size_t) {
+        std::string word = words[rng() % words.size()];
+        word[word.size() / 2] = 'e';
+        found += dictionary.suggest(nstring(word)).size();
+    });
+
+    if (found == 0) std::cout << std::endl;
+}
+
+void benchLayout() {
+    // fixed-width glyphs stand in for the fonts
+    std::mt19937 rng(13);
+    nstring text = prose(rng, 1 << 14);
+    layout::FixedMetrics metrics;
+    layout::Positions positions;
+
+    std::size_t placed = 0;
+    run("layout/wrap/page", 200, [&](std::size_t) {
+        layout::wrap(text, metrics, {1100, 1453}, positions);
+        placed += positions.size();
+    });
+
+    run("layout/wrap/unbounded", 20, [&](std::size_t) {
+        layout::wrap(text, metrics, {1100, 1e9}, positions);
+        placed += positions.size();
+    });
+
+    // about 500 pages, laid out all at once as after opening it
+    Rope book = build(prose(rng, 1 << 20));
+    std::size_t hardware = std::thread::hardware_concurrency();
+    for (std::size_t threads : {1, 2, 4, 8}) {
+        if (threads > 1 && threads > hardware) break;
+        run("layout/paragraphs/" + std::to_string(threads) + "_threads", 5,
+            [&](std::size_t) {
+                layout::wrap_paragraphs(book, metrics, 1100, positions,
+                                        threads);
+                placed += positions.size();
+            });
+    }
+
+    // a drag over the laid out book, one hit test a frame
+    float height = layout::wrap_paragraphs(book, metrics, 1100, positions);
+    run("layout/hit_test/random", 1000000, [&](std::size_t) {
+        Vector2 point = {float(rng() % 1200), float(rng() % int(height))};
+        placed += positions.hit_test(point);
+    });
+
+    run("layout/at/random", 1000000, [&](std::size_t) {
+        placed += positions.at(rng() % positions.size()).x;
+    });
+
+    if (placed == 0) std::cout << std::endl;
+}
+
+bool write_json(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+#ifdef NDEBUG
+    bool optimized = true;
+#else
+    bool optimized = false;
+#endif
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"optimized\": " << (optimized ? "true" : "false")
+        << ",\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << result.name
+            << "\", \"ops\": " << result.ops
+            << ", \"ns_per_op\": " << result.nsPerOp
+            << ", \"allocs_per_op\": " << result.allocsPerOp
+            << ", \"bytes_per_op\": " << result.bytesPerOp << "}";
+    }
+    out << "\n  ]\n}\n";
+    return !!out;
+}
+
+int main(int argc, char** argv) {
+    const char* usage = "usage: bench [--output FILE]\n"
+                        "  -o, --output FILE  write the results as JSON to "
+                        "FILE (bench.json)\n"
+                        "  -h, --help         show this help\n";
+
+    std::string output = "bench.json";
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help") {
+            std::cout << usage;
+            return 0;
+        }
+        if (argument == "-o" || argument == "--output") {
+            if (i + 1 == argc) {
+                std::cerr << "bench: " << argument << " needs a file\n"
+                          << usage;
+                return 2;
+            }
+            output = argv[++i];
+            continue;
+        }
+
+        // anything else would have been taken for a file name
+        std::cerr << "bench: unexpected argument '" << argument << "'\n"
+                  << usage;
+        return 2;
+    }
+
+    std::cout << std::left << std::setw(32) << "benchmark" << std::right
+              << std::setw(10) << "ops" << std::setw(14) << "ns/op"
+              << std::setw(12) << "allocs/op" << std::setw(14) << "bytes/op"
+              << std::endl;
+
+    benchRope();
+    benchSearch();
+    benchDictionary();
+    benchLayout();
+
+    if (!write_json(output)) {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << output << std::endl;
+
+    return 0;
+}
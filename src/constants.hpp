@@ -1,4 +1,6 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 #include "raylib.h"
@@ -36,6 +38,29 @@ namespace constants::document {
 
     constexpr Color default_background_color = WHITE;
 
+    // files at least this large are memory-mapped instead of loaded
+    constexpr std::uintmax_t mapped_threshold = 64 << 20;
+
+    // save_as() writes the native format, with styles, to these files
+    const std::string native_extension = ".ndoc";
+
+    // unsaved edits of a document are journaled next to it, in files named
+    // after it with this suffix
+    const std::string journal_extension = ".journal";
+
+    // keep the undo history as an operation log, saved next to the document
+    // in a file with this suffix and restored when it is opened again,
+    // instead of rope snapshots kept in memory only
+    constexpr bool persistent_undo = false;
+    const std::string undo_extension = ".undo";
+
+    // a journal that failed to write is started over at most this often
+    constexpr std::chrono::seconds journal_retry{5};
+
+    // untitled documents are journaled in this directory of the user's
+    // state directory ($XDG_STATE_HOME, or ~/.local/state)
+    const std::string state_directory = "document-editor";
+
 }  // namespace constants::document
 
 namespace constants::dictionary {
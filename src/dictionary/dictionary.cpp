@@ -2,6 +2,7 @@
 
 #include <fstream>
 
+#include "profile/profiler.hpp"
 #include "text/utils.hpp"
 
 Dictionary::Dictionary() {
@@ -36,11 +37,16 @@ void Dictionary::loadDatabase(const std::string& path) {
     file.close();
 
     mSuggester.set_suggestion_keywords(words);
+    mLoaded = true;
 }
 
+bool Dictionary::is_loaded() const { return mLoaded; }
+
 // currently my dictionary only support English language so this function still
 // use std::string
 bool Dictionary::search(const nstring& word) const {
+    PROFILE_SCOPE("Dictionary::search");
+
     std::string wordLower = tolower(word.to_string());
     return mRoots[static_cast< std::size_t >(mLanguage)]->search(wordLower);
 }
@@ -48,6 +54,8 @@ bool Dictionary::search(const nstring& word) const {
 // currently my dictionary only support English language so this function still
 // use std::string
 std::vector< nstring > Dictionary::suggest(const nstring& word) {
+    PROFILE_SCOPE("Dictionary::suggest");
+
     std::string wordL = tolower(word.to_string());
     mSuggester.set_pattern(wordL);
     return mSuggester.suggest();
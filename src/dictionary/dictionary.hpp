@@ -14,6 +14,7 @@ public:
     ~Dictionary();
 
     void loadDatabase(const std::string& path);
+    bool is_loaded() const;
 
     bool search(const nstring& word) const;
 
@@ -27,6 +28,8 @@ private:
 
     std::array< Database*, locale_language::NUM_LANGUAGES > mRoots{};
     locale_language mLanguage{constants::dictionary::default_language};
+
+    bool mLoaded{false};
 };
 
 #endif  // DICTIONARY_DICTIONARY_HPP
\ No newline at end of file
@@ -1,77 +1,352 @@
 #include "document.hpp"
 
+#include <signal.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
+#include <sstream>
 
 #include "constants.hpp"
+#include "history/operation_log.hpp"
+#include "io/atomic_file.hpp"
+#include "io/native_file.hpp"
+#include "io/text_file.hpp"
+#include "layout/layout.hpp"
+#include "profile/profiler.hpp"
 #include "utils.hpp"
 
-Document::Document() : mRope{"\n"} {}
+namespace {
+    const std::string untitledPrefix = "Untitled-";
+
+    // where the journals of untitled documents are kept
+    std::filesystem::path state_directory() {
+        namespace fs = std::filesystem;
+
+        fs::path directory;
+        std::error_code error;
+        if (const char* state = std::getenv("XDG_STATE_HOME");
+            state && *state) {
+            directory = state;
+        } else if (const char* home = std::getenv("HOME"); home && *home) {
+            directory = fs::path(home) / ".local" / "state";
+        } else {
+            directory = fs::temp_directory_path(error);
+        }
+        return directory / constants::document::state_directory;
+    }
+
+    // one journal per untitled document of every running editor
+    std::string untitled_journal_path() {
+        static std::atomic< unsigned > count{0};
+
+        std::filesystem::path directory = state_directory();
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
 
-Document::Document(std::string filename) : mFilename{filename} {
-    // not implemented yet
+        std::string name = untitledPrefix + std::to_string(::getpid()) + "-" +
+                           std::to_string(count++);
+        return (directory / name).string() +
+               constants::document::journal_extension;
+    }
+
+    // Whether the editor that wrote the journal named `name` is gone
+    bool is_orphaned(const std::string& name) {
+        const std::string& extension = constants::document::journal_extension;
+        if (name.rfind(untitledPrefix, 0) != 0 ||
+            name.size() <= extension.size() ||
+            name.compare(name.size() - extension.size(), extension.size(),
+                         extension) != 0) {
+            return false;
+        }
+
+        pid_t pid = std::atoi(name.c_str() + untitledPrefix.size());
+        if (pid <= 0 || pid == ::getpid()) return false;
+        return ::kill(pid, 0) != 0 && errno == ESRCH;
+    }
+}  // namespace
+
+Document::Document() : mRope{"\n"}, mSavedRoot{mRope.root()} {
+    if (constants::document::persistent_undo) {
+        set_undo_backend(std::make_unique< OperationLog >());
+    }
+}
+
+Document::Document(std::string filename) : Document() { open(filename); }
+
+Document::~Document() { close_journal(); }
+
+void Document::open(const std::string& filename) {
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(filename, error);
+
+    close_journal();
+
+    bool native = io::is_native(filename);
+    bool mapped = !native && !error &&
+                  size >= constants::document::mapped_threshold;
+
+    if (native) {
+        // chunks are mapped and decoded on demand, whatever the size
+        mRope = io::load_native(filename);
+        mIndexer.reset();
+    } else if (mapped) {
+        // huge files open read-only until the background index is done
+        mIndexer = std::make_unique< io::MappedText >(filename);
+        mRope = mIndexer->preview();
+    } else {
+        mRope = io::load_text(filename);
+        mIndexer.reset();
+    }
+    mFilename = filename;
+    mJournalPath = filename + constants::document::journal_extension;
+    mFormat = native ? io::Format::Native : io::Format::Text;
+    mSavedRoot = mRope.root();
+    mSaveError.clear();
+    if (!mapped) recover();
+    // checking would decode the whole file into memory
+    mSpellChecking = !mapped;
+
+    mCursorIndex = 0;
+    clear_cursors();
+    turn_off_selecting();
+    mHistory->clear();
+    load_undo();
+
+    refresh();
 }
 
 void Document::set_font_factory(FontFactory* fonts) { mFonts = fonts; }
 
-void Document::set_document_fonts(DocumentFont* docFonts) {
-    mDocFonts = docFonts;
+void Document::set_glyph_metrics(const layout::GlyphMetrics* metrics) {
+    mMetrics = metrics;
 }
 
 void Document::set_dictionary(Dictionary* dictionary) {
     mDictionary = dictionary;
+
+    mSpellChecker.set_dictionary(dictionary,
+                                 constants::dictionary::default_database_path);
+    if (mSpellChecking) mSpellChecker.submit(mRope);
 }
 
+void Document::update() {
+    while (auto saved = mSaver.poll()) {
+        if (saved->ok()) {
+            // a save under another name does not count for this one
+            if (saved->path == mFilename) mSavedRoot = saved->rope.root();
+            mSaveError.clear();
+
+            // nothing left to recover
+            if (mJournal && !is_modified()) {
+                mJournal->discard();
+                mJournal.reset();
+            }
+        } else {
+            mSaveError = saved->error;
+        }
+    }
+    check_journal();
+
+    if (!mIndexer) return;
+
+    if (auto indexed = mIndexer->take_result()) {
+        // the preview is the beginning of the indexed rope, so the cursor
+        // stays valid
+        mRope = *indexed;
+        mSavedRoot = mRope.root();
+        mIndexer.reset();
+        refresh();
+    }
+}
+
+bool Document::save() {
+    // the preview is only the beginning of the file
+    if (is_read_only()) return false;
+
+    mSaver.save(mRope, mFilename, mFormat);
+    save_undo();
+    return true;
+}
+
+bool Document::save_as(const std::string& filename) {
+    if (is_read_only()) return false;
+
+    const std::string& extension = constants::document::native_extension;
+    bool native = filename.size() >= extension.size() &&
+                  filename.compare(filename.size() - extension.size(),
+                                   extension.size(), extension) == 0;
+
+    // the journal is named after the file
+    if (mJournal) {
+        mJournal->discard();
+        mJournal.reset();
+    }
+
+    mFilename = filename;
+    mJournalPath = filename + constants::document::journal_extension;
+    mFormat = native ? io::Format::Native : io::Format::Text;
+    if (is_modified()) {
+        mJournal = std::make_unique< io::Journal >(journal_path(), mRope);
+    }
+    return save();
+}
+
+bool Document::is_saving() const { return mSaver.busy(); }
+
+bool Document::is_modified() const { return mRope.root() != mSavedRoot; }
+
+const std::string& Document::save_error() const { return mSaveError; }
+
+bool Document::is_read_only() const { return mIndexer != nullptr; }
+
+std::optional< io::MappedText::Progress > Document::indexing_progress()
+    const {
+    if (!mIndexer) return std::nullopt;
+    return mIndexer->progress();
+}
+
+std::size_t Document::laid_out_length() const { return mPositions.size(); }
+
 Rope& Document::rope() { return mRope; }
 
 const Rope& Document::rope() const { return mRope; }
 
-Cursor& Document::cursor() { return mCursor; }
+const Cursor& Document::cursor() const {
+    // edits, undo and opening a file all replace the root
+    if (mCursorRoot != mRope.root() ||
+        mCursor.index != static_cast< int >(mCursorIndex)) {
+        mCursor = cursor_at(mCursorIndex);
+        mCursorRoot = mRope.root();
+    }
+    return mCursor;
+}
 
-const Cursor& Document::cursor() const { return mCursor; }
+std::size_t Document::cursor_index() const { return mCursorIndex; }
 
-void Document::set_cursor(Cursor cursor) { mCursor = cursor; }
+void Document::set_cursor(Cursor cursor) {
+    set_cursor_index(mRope.index_from_pos(cursor.line, cursor.column));
+}
+
+void Document::set_cursor_index(std::size_t index) {
+    // jumping somewhere else ends the current typing run
+    if (index != mCursorIndex) mHistory->seal();
+    clear_cursors();
+    move_cursor(index);
+}
 
 std::string& Document::filename() { return mFilename; }
 
 const std::string& Document::filename() const { return mFilename; }
 
-Cursor& Document::select_orig() { return mSelectOrig; }
+Document::Range Document::selection() const {
+    if (!mIsSelecting) return {mCursorIndex, mCursorIndex};
 
-const Cursor& Document::select_orig() const { return mSelectOrig; }
+    // the anchor may be past the end after an undo
+    std::size_t anchor = std::min(mSelectAnchor, mRope.length());
+    return std::minmax(anchor, mCursorIndex);
+}
 
-const Cursor& Document::select_start() const {
-    return mCursor < mSelectOrig ? mCursor : mSelectOrig;
+Cursor Document::select_start() const { return cursor_at(selection().first); }
+
+Cursor Document::select_end() const { return cursor_at(selection().second); }
+
+void Document::add_cursor(std::size_t index) { add_selection({index, index}); }
+
+void Document::add_selection(Range range) {
+    range.second = std::min(range.second, mRope.length());
+    range.first = std::min(range.first, range.second);
+    mCursors.insert(
+        std::upper_bound(mCursors.begin(), mCursors.end(), range), range);
+}
+
+void Document::select_matches(const Search& search) {
+    const auto& matches = search.match_idx();
+    if (matches.empty()) return;
+
+    std::size_t length = search.pattern().length();
+    set_cursor_index(matches.front() + length);
+    mSelectAnchor = matches.front();
+    mIsSelecting = true;
+
+    // the matches are sorted already
+    mCursors.reserve(matches.size() - 1);
+    for (auto match = matches.begin() + 1; match != matches.end(); ++match) {
+        mCursors.push_back({*match, *match + length});
+    }
 }
 
-const Cursor& Document::select_end() const {
-    return mCursor > mSelectOrig ? mCursor : mSelectOrig;
+void Document::clear_cursors() { mCursors.clear(); }
+
+std::size_t Document::cursor_count() const { return selections().size(); }
+
+std::vector< Document::Range > Document::selections() const {
+    std::vector< Range > ranges;
+    ranges.reserve(mCursors.size() + 1);
+    for (Range range : mCursors) {
+        // an erase of the primary selection may leave them past the end
+        range.first = std::min(range.first, mRope.length());
+        range.second = std::min(range.second, mRope.length());
+        ranges.push_back(range);
+    }
+    ranges.insert(std::upper_bound(ranges.begin(), ranges.end(), selection()),
+                  selection());
+
+    // a cursor touching a selection, or another cursor, joins it
+    std::vector< Range > merged;
+    merged.reserve(ranges.size());
+    for (const Range& range : ranges) {
+        bool touches = false;
+        if (!merged.empty()) {
+            const Range& previous = merged.back();
+            bool empty = range.first == range.second ||
+                         previous.first == previous.second;
+            touches = range.first < previous.second ||
+                      (range.first == previous.second && empty);
+        }
+
+        if (touches) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    return merged;
 }
 
 void Document::cursor_move_line(int delta) {
-    mCursor.line = std::clamp(mCursor.line + delta, 0,
-                              static_cast< int >(mRope.line_count()) - 1);
+    clear_cursors();
+    const Cursor& current = cursor();
+    int line = std::clamp(current.line + delta, 0,
+                          static_cast< int >(mRope.line_count()) - 1);
+    int column = std::min< int >(current.column, mRope.line_length(line));
 
-    cursor_move_column(0);
+    move_cursor(mRope.index_from_pos(line, column));
 }
 
 void Document::cursor_move_column(int delta) {
-    int lineLength = mRope.line_length(mCursor.line);
+    clear_cursors();
+    const Cursor& current = cursor();
+    int lineLength = mRope.line_length(current.line);
+    int column = std::clamp(current.column + delta, 0, lineLength);
 
-    // int right_offset =
-    //     (mCursor.line + 1 == static_cast< int >(mRope.line_count()));
-    mCursor.column = std::clamp(mCursor.column + delta, 0, lineLength);
-
-    if (mCursor.column < 0) {
-        mCursor.column = 0;
-    }
+    move_cursor(mCursorIndex - current.column + column);
 }
 
 void Document::cursor_move_next_word() {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
-    if (pos == mRope.length()) return;
-    cursor_move_next_char();
+    clear_cursors();
+    std::size_t start = mCursorIndex;
+    if (start == mRope.length()) return;
 
+    // count the characters to pass, then move once
+    std::size_t pos = start, steps = 1;
     int c = mRope[pos].codepoint();
     bool alnum_word = !!std::isalnum(c);
     bool punct_word = !!std::ispunct(c);
@@ -79,12 +354,13 @@ void Document::cursor_move_next_word() {
     if (alnum_word) {
         for (; pos + 2 < mRope.length() && std::isalnum(mRope[pos].codepoint());
              ++pos) {
-            cursor_move_next_char();
+            ++steps;
         }
     } else if (pos + 2 < mRope.length() && punct_word) {
         ++pos;
-        cursor_move_next_char();
+        ++steps;
         if (std::ispunct(mRope[pos].codepoint())) {
+            move_cursor(std::min(start + steps, mRope.length()));
             return;
         }
     }
@@ -92,50 +368,41 @@ void Document::cursor_move_next_word() {
     if (std::isspace(c)) {
         for (; pos + 2 < mRope.length() && std::isspace(mRope[pos].codepoint());
              ++pos) {
-            cursor_move_next_char();
+            ++steps;
         }
     }
+
+    move_cursor(std::min(start + steps, mRope.length()));
 }
 
 void Document::cursor_move_prev_word() {
-    if (mCursor.column == 0 && mCursor.line == 0) return;
-    cursor_move_prev_char();
+    clear_cursors();
+    if (mCursorIndex == 0) return;
 
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex - 1;
     int c = mRope[pos].codepoint();
 
-    for (; pos > 0 && std::isspace(mRope[pos].codepoint()); --pos) {
-        cursor_move_prev_char();
-    }
-
-    if (std::ispunct(c)) return;
+    while (pos > 0 && std::isspace(mRope[pos].codepoint())) --pos;
 
-    for (; pos > 0 && std::isalnum(mRope[pos - 1].codepoint()); --pos) {
-        cursor_move_prev_char();
+    if (!std::ispunct(c)) {
+        while (pos > 0 && std::isalnum(mRope[pos - 1].codepoint())) --pos;
     }
+
+    move_cursor(pos);
 }
 
 void Document::cursor_move_next_char() {
-    if (mCursor.column == mRope.line_length(mCursor.line)) {
-        if (mCursor.line + 1 < mRope.line_count()) {
-            ++mCursor.line;
-            mCursor.column = 0;
-        }
-    } else {
-        ++mCursor.column;
-    }
+    clear_cursors();
+    // the end of a line is its line feed, the next index starts the next line
+    move_cursor(std::min(mCursorIndex + 1, mRope.length()));
 }
 
 void Document::cursor_move_prev_char() {
-    if (mCursor.column > 0) {
-        --mCursor.column;
-    } else if (mCursor.line > 0) {
-        --mCursor.line;
-        mCursor.column = mRope.line_length(mCursor.line);
-    }
+    clear_cursors();
+    if (mCursorIndex > 0) move_cursor(mCursorIndex - 1);
 }
 
-Cursor Document::pos_on_mouse() const {
+std::size_t Document::index_on_mouse() const {
     Vector2 pos = GetMousePosition();
     pos.x -=
         constants::document::padding_left +
@@ -144,150 +411,208 @@ Cursor Document::pos_on_mouse() const {
             (GetScreenWidth() - constants::document::default_view_width) / 2);
     pos.y -= constants::document::padding_top + constants::document::margin_top;
 
-    auto it = std::lower_bound(displayPositions.begin(), displayPositions.end(),
-                               pos, utils::cmpVector2);
-    if (it == displayPositions.begin()) {
-        return {0, 0};
-    }
-
-    pos.y = (--it)->y;
+    // the positions end with one past the text, for the caret at its end
+    return std::min(mPositions.hit_test(pos), mRope.length());
+}
 
-    std::size_t document_pos =
-        lower_bound(displayPositions.begin(), displayPositions.end(), pos,
-                    utils::cmpVector2) -
-        displayPositions.begin();
-    if (document_pos == displayPositions.size()) {
-        document_pos = displayPositions.size() - 1;
-    }
+void Document::insert_at_cursor(const nstring& text) {
+    insert_at_cursor(Rope(text));
+}
 
-    if (displayPositions[document_pos].y != pos.y) {
-        document_pos--;
+void Document::insert_at_cursor(const Rope& text) {
+    if (!mCursors.empty()) {
+        replace_ranges(selections(), text);
+        return;
     }
 
-    auto [line, column] = mRope.pos_from_index(document_pos);
-
-    return Cursor{static_cast< int >(line), static_cast< int >(column)};
-}
+    std::size_t pos = mCursorIndex;
+    if (!apply({history::EditKind::Typing, pos, nstring(), text})) return;
 
-void Document::insert_at_cursor(const nstring& text) {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
-    mRope = mRope.insert(pos, text);
+    move_cursor(pos + text.length());
 
-    for (std::size_t i = 0; i < text.length(); ++i) {
-        cursor_move_next_char();
+    // undo typing word by word
+    if (text.length() && std::isspace(text[text.length() - 1].codepoint())) {
+        mHistory->seal();
     }
 
-    processWordWrap();
+    refresh();
 }
 
 void Document::append_at_cursor(const nstring& text) {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
-    mRope = mRope.insert(pos, text);
+    std::size_t pos = mCursorIndex;
+    if (!apply({history::EditKind::Typing, pos, nstring(), text})) return;
 
-    for (std::size_t i = 0; i < text.length(); ++i) {
-        cursor_move_next_char();
-    }
+    move_cursor(pos + text.length());
 
-    processWordWrap();
+    refresh();
 }
 
 void Document::erase_at_cursor() {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    if (!mCursors.empty()) {
+        // cursors erase the character before them, selections themselves
+        std::vector< Range > ranges = selections();
+        for (auto& range : ranges) {
+            if (range.first == range.second && range.first > 0) --range.first;
+        }
+        replace_ranges(ranges, Rope());
+        return;
+    }
+
+    std::size_t pos = mCursorIndex;
     if (pos == 0) return;
 
-    cursor_move_prev_char();
-    mRope = mRope.erase(pos - 1, 1);
+    if (!apply({history::EditKind::Erase, pos - 1, mRope.subrope(pos - 1, 1),
+                nstring()})) {
+        return;
+    }
 
-    processWordWrap();
+    move_cursor(pos - 1);
+
+    refresh();
 }
 
 void Document::erase_selected() {
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
+    if (!mCursors.empty()) {
+        replace_ranges(selections(), Rope());
+        return;
+    }
+
+    auto [start, end] = selection();
 
     erase_range(start, end);
 }
 
 void Document::erase_range(std::size_t start, std::size_t end) {
-    save_snapshot();
-
-    mRope = mRope.erase(start, end - start);
+    // the document always keeps its final newline
+    nstring inserted = end - start == mRope.length() ? "\n" : "";
+    apply({history::EditKind::Other, start, mRope.subrope(start, end - start),
+           inserted});
 
-    set_cursor(select_start());
-    if (mRope.length() == 0) {
-        mRope = mRope.append("\n");
-    }
-    processWordWrap();
+    set_cursor_index(start);
+    refresh();
 }
 
 void Document::copy_selected() {
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
+    auto [start, end] = selection();
 
     copy_range(start, end);
 }
 
 void Document::copy_range(std::size_t start, std::size_t end) {
-    std::string text = mRope.substr(start, end - start);
+    std::string text = io::encode_text(mRope.subrope(start, end - start));
     SetClipboardText(text.c_str());
 }
 
-void Document::save_snapshot() {
-    mUndo.push_back({mRope, mCursor});
-    mRedo.clear();
+void Document::paste() {
+    const char* clipboard = GetClipboardText();
+    if (!clipboard) return;
+
+    // straight into leaves, never one nstring of the whole clipboard
+    Rope text = io::decode_text(clipboard, std::strlen(clipboard));
+
+    // a paste is undone on its own, not with the typing around it
+    mHistory->seal();
+    insert_at_cursor(text);
+    mHistory->seal();
 }
 
 void Document::undo() {
-    if (mUndo.empty()) return;
+    // the history keeps line and column, which survive a saved log
+    Rope before = mRope;
+    Cursor restored = cursor();
+    if (!mHistory->undo(mRope, restored)) return;
+    restore(before, restored);
+}
 
-    mRedo.push_back({mRope, mCursor});
-    const auto& [prev_rope, prev_cursor] = mUndo.back();
+void Document::redo() {
+    Rope before = mRope;
+    Cursor restored = cursor();
+    if (!mHistory->redo(mRope, restored)) return;
+    restore(before, restored);
+}
 
-    mRope = prev_rope;
-    set_cursor(prev_cursor);
+void Document::restore(const Rope& before, const Cursor& restored) {
+    clear_cursors();
+    move_cursor(mRope.index_from_pos(restored.line, restored.column));
 
-    mUndo.pop_back();
+    // journaled as the edit between the two states, not as a snapshot
+    history::Edit edit = history::diff(before, mRope);
+    bool changed = edit.removed.length() || edit.inserted.length();
+    if (mJournal && changed) mJournal->append(edit);
 
-    processWordWrap();
+    if (mOutlineRoot == before.root()) {
+        mOutline.update(mRope, edit.position, edit.removed.length(),
+                        edit.inserted.length());
+        mOutlineRoot = mRope.root();
+    }
+    refresh();
 }
 
-void Document::redo() {
-    if (mRedo.empty()) return;
+UndoBackend& Document::history() { return *mHistory; }
+
+void Document::set_undo_backend(std::unique_ptr< UndoBackend > backend) {
+    // the old entries refer to states the new backend never saw
+    mHistory = std::move(backend);
+    mHistory->clear();
+}
 
-    mUndo.push_back({mRope, mCursor});
-    const auto& [next_rope, next_cursor] = mRedo.back();
+std::string Document::undo_path() const {
+    return mFilename + constants::document::undo_extension;
+}
 
-    mRope = next_rope;
-    set_cursor(next_cursor);
+void Document::save_undo() {
+    auto log = dynamic_cast< const OperationLog* >(mHistory.get());
+    if (!log) return;
+
+    // replays to the text being saved, so the next open can trust it
+    std::ostringstream out(std::ios::binary);
+    log->save(out);
+    try {
+        io::AtomicFile file(undo_path());
+        file.write(out.str());
+        file.commit();
+    } catch (const std::runtime_error& error) {
+        mSaveError = error.what();
+    }
+}
 
-    mRedo.pop_back();
+void Document::load_undo() {
+    auto log = dynamic_cast< OperationLog* >(mHistory.get());
+    if (!log || is_read_only()) return;
 
-    processWordWrap();
+    std::ifstream in(undo_path(), std::ios::binary);
+    if (!in) return;
+
+    // a log of another version of the file, changed elsewhere or by a
+    // recovered journal, would undo into nonsense
+    Rope replayed;
+    if (!log->load(in, replayed)) {
+        log->clear();
+        return;
+    }
+    history::Edit change = history::diff(replayed, mRope);
+    if (change.removed.length() || change.inserted.length()) log->clear();
 }
 
 Vector2 Document::get_display_positions(std::size_t index) const {
-    if (index >= displayPositions.size()) {
+    if (index >= mPositions.size()) {
         return {0, 0};
     }
 
-    return displayPositions[index];
+    return mPositions.at(index);
 }
 
-void Document::turn_on_selecting() { mIsSelecting = true; }
-
-void Document::turn_off_selecting() {
-    mSelectOrig = {-1, -1};
-    mIsSelecting = false;
+void Document::turn_on_selecting() {
+    mSelectAnchor = mCursorIndex;
+    mIsSelecting = true;
 }
 
+void Document::turn_off_selecting() { mIsSelecting = false; }
+
 bool Document::is_selecting() const { return mIsSelecting; }
 
 bool Document::check_word_at_cursor() {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -296,11 +621,14 @@ bool Document::check_word_at_cursor() {
         ++right;
 
     nstring word = mRope.subnstr(left, right - left);
-    return mDictionary->search(word);
+    return mSpellChecker.check(word);
 }
 
 std::vector< nstring > Document::suggest_at_cursor() {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    // the dictionary may still be loading on the spell checker thread
+    if (!mSpellChecker.ready()) return {};
+
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -312,163 +640,71 @@ std::vector< nstring > Document::suggest_at_cursor() {
     return mDictionary->suggest(word);
 }
 
-std::vector< std::pair< std::size_t, nstring > > Document::get_outline() const {
-    std::vector< std::pair< std::size_t, nstring > > headings;
-
-    // return some examples
-    headings.push_back({1, "Heading 1 hello everyone xin chao cac ban"});
-    headings.push_back({2, "Heading 2"});
-    headings.push_back({3, "Heading 3"});
-    headings.push_back({4, "Heading 4"});
-    headings.push_back({5, "Heading 5"});
-
-    return headings;
-
-    // std::size_t pos = 0;
-    // while (pos < mRope.length()) {
-    //     if (mRope[pos].codepoint() == '#') {
-    //         int level = 0;
-    //         while (pos < mRope.length() && mRope[pos].codepoint() == '#') {
-    //             ++level;
-    //             ++pos;
-    //         }
-
-    //         while (pos < mRope.length() &&
-    //         std::isspace(mRope[pos].codepoint()))
-    //             ++pos;
-
-    //         int start = pos;
-    //         while (pos < mRope.length() && mRope[pos].codepoint() != '\n')
-    //             ++pos;
-
-    //         nstring heading = mRope.subnstr(start, pos - start);
-
-    //         headings.push_back({level, heading});
-    //     } else {
-    //         ++pos;
-    //     }
-    // }
+const std::vector< SpellChecker::Range >& Document::misspelled_ranges() {
+    mSpellChecker.poll(mMisspelled);
+    return mMisspelled;
+}
 
-    // return headings;
+const std::vector< Outline::Heading >& Document::get_outline() const {
+    if (mOutlineRoot != mRope.root()) {
+        mOutline.rebuild(mRope);
+        mOutlineRoot = mRope.root();
+    }
+    return mOutline.headings();
 }
 
 void Document::underline_selected() {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.toggleUnderline(0, selected.length());
+    auto [start, end] = selection();
 
-    mRope = mRope.replace(start, end - start, selected);
+    toggle_type(start, end, nchar::Underline);
 }
 
 void Document::strikethrough_selected() {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.toggleStrikethrough(0, selected.length());
+    auto [start, end] = selection();
 
-    mRope = mRope.replace(start, end - start, selected);
+    toggle_type(start, end, nchar::Strikethrough);
 }
 
 void Document::bold_selected() {
-    save_snapshot();
+    auto [start, end] = selection();
 
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
+    toggle_type(start, end, nchar::Bold);
 
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.toggleBold(0, selected.length());
-
-    mRope = mRope.replace(start, end - start, selected);
-
-    processWordWrap();
+    refresh();
 }
 
 void Document::italic_selected() {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.toggleItalic(0, selected.length());
+    auto [start, end] = selection();
 
-    mRope = mRope.replace(start, end - start, selected);
+    toggle_type(start, end, nchar::Italic);
 
-    processWordWrap();
+    refresh();
 }
 
 void Document::subscript_selected() {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.toggleSubscript(0, selected.length());
+    auto [start, end] = selection();
 
-    mRope = mRope.replace(start, end - start, selected);
+    toggle_type(start, end, nchar::Subscript);
 
-    processWordWrap();
+    refresh();
 }
 
 void Document::superscript_selected() {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
+    auto [start, end] = selection();
 
-    selected.toggleSuperscript(0, selected.length());
+    toggle_type(start, end, nchar::Superscript);
 
-    mRope = mRope.replace(start, end - start, selected);
-
-    processWordWrap();
+    refresh();
 }
 
 void Document::set_text_color_selected(Color color) {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
+    auto [start, end] = selection();
 
-    selected.setColor(color);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.color = color});
 }
 
 void Document::set_text_color(Color color) {
-    save_snapshot();
-
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -478,38 +714,23 @@ void Document::set_text_color(Color color) {
 
     int start = left, end = right;
 
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.setColor(color);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.color = color});
 }
 
 Color Document::get_text_color() const {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     return mRope[pos].getColor();
 }
 
 void Document::set_background_color_selected(Color color) {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.setBackgroundColor(color);
+    auto [start, end] = selection();
 
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.backgroundColor = color});
 }
 
 void Document::set_background_color(Color color) {
-    save_snapshot();
-
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -519,38 +740,23 @@ void Document::set_background_color(Color color) {
 
     int start = left, end = right;
 
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.setBackgroundColor(color);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.backgroundColor = color});
 }
 
 Color Document::get_background_color() const {
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     return mRope[pos].getBackgroundColor();
 }
 
 void Document::set_font_size_selected(int size) {
-    save_snapshot();
+    auto [start, end] = selection();
 
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.setFontSize(size);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.fontSize = size});
 }
 
 void Document::set_font_size(int size) {
-    save_snapshot();
-
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -560,31 +766,17 @@ void Document::set_font_size(int size) {
 
     int start = left, end = right;
 
-    nstring selected = mRope.subnstr(start, end - start);
-
-    selected.setFontSize(size);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.fontSize = size});
 }
 
 void Document::set_font_id_selected(std::size_t id) {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
+    auto [start, end] = selection();
 
-    nstring selected = mRope.subnstr(start, end - start);
-    selected.setFontId(id);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.fontId = id});
 }
 
 void Document::set_font_id(std::size_t id) {
-    save_snapshot();
-
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -594,32 +786,16 @@ void Document::set_font_id(std::size_t id) {
 
     int start = left, end = right;
 
-    nstring selected = mRope.subnstr(start, end - start);
-    selected.setFontId(id);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.fontId = id});
 }
 
 void Document::set_link_selected(std::string link) {
-    save_snapshot();
-
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-    nstring selected = mRope.subnstr(start, end - start);
-    selected.setLink(link);
-
-    mRope = mRope.replace(start, end - start, selected);
-
-    std::cout << link << " | " << selected.getLink() << " "
-              << mRope[start].getLink() << std::endl;
+    auto [start, end] = selection();
+    restyle(start, end, StylePatch{.link = link});
 }
 
 void Document::set_link(std::string link) {
-    save_snapshot();
-
-    std::size_t pos = mRope.index_from_pos(mCursor.line, mCursor.column);
+    std::size_t pos = mCursorIndex;
 
     int left = pos, right = pos;
 
@@ -629,161 +805,232 @@ void Document::set_link(std::string link) {
 
     int start = left, end = right;
 
-    nstring selected = mRope.subnstr(start, end - start);
-    selected.setLink(link);
-
-    mRope = mRope.replace(start, end - start, selected);
+    restyle(start, end, StylePatch{.link = link});
 }
 
 std::string Document::get_link_selected() const {
     if (!is_selecting()) return std::string();
-    std::size_t start =
-        mRope.index_from_pos(select_start().line, select_start().column);
-    std::size_t end =
-        mRope.index_from_pos(select_end().line, select_end().column);
-    nstring selected = mRope.subnstr(start, end - start);
+    auto [start, end] = selection();
+    if (start == end) return std::string();
 
-    return selected.getLink();
+    // the link of the first character, like nstring::getLink()
+    return mRope[start].getLink();
 }
 
-void Document::processWordWrap() {
-    auto getFont = [&](const nchar& c) -> Font {
-        if (c.isBold() && c.isItalic()) {
-            return mDocFonts->get_bold_italic_font(c.getFontId());
-        } else if (c.isBold()) {
-            return mDocFonts->get_bold_font(c.getFontId());
-        } else if (c.isItalic()) {
-            return mDocFonts->get_italic_font(c.getFontId());
-        }
-        return mDocFonts->get_font(c.getFontId());
-    };
+void Document::restyle(std::size_t start, std::size_t end,
+                       const StylePatch& patch) {
+    Rope removed = mRope.subrope(start, end - start);
+    apply({history::EditKind::Style, start, removed,
+           removed.restyle(0, removed.length(), patch)});
+}
+
+void Document::toggle_type(std::size_t start, std::size_t end,
+                           nchar::Type type) {
+    // like nstring::toggleType(): on, unless the whole range has it already
+    bool on = !mRope.has_type(start, end - start, type);
+    restyle(start, end, StylePatch::type(type, on));
+}
+
+bool Document::apply(const history::Edit& edit) {
+    if (is_read_only()) return false;
+    if (edit.removed.length() == 0 && edit.inserted.length() == 0 &&
+        edit.others.empty()) {
+        return false;
+    }
 
-    nstring content = mRope.to_nstring() + nstring("?");
-    int length = content.length();
+    // the journal starts from the state before its first edit
+    if (!mJournal) {
+        mJournal = std::make_unique< io::Journal >(journal_path(), mRope);
+    }
+    mJournal->append(edit);
+
+    mHistory->record(mRope, cursor(), edit);
+    bool outlined = mOutlineRoot == mRope.root();
+    mRope = history::apply(mRope, edit);
+
+    // keep the tree shallow, long editing sessions would otherwise recurse
+    // as deep as the number of edits
+    if (!mRope.is_balanced()) mRope = mRope.rebalance();
+
+    // a style change keeps every character, and with them the headings
+    if (outlined) {
+        if (edit.kind != history::EditKind::Style) {
+            std::vector< Outline::Change > changes{
+                {edit.position, edit.removed.length(),
+                 edit.inserted.length()}};
+            for (const auto& other : edit.others) {
+                changes.push_back({other.position, other.removed.length(),
+                                   other.inserted.length()});
+            }
+            mOutline.update(mRope, changes);
+        }
+        mOutlineRoot = mRope.root();
+    }
+    return true;
+}
 
-    bool wordWrap = 1;
-    Rectangle rec = {0, 0,
-                     constants::document::default_view_width -
-                         2 * constants::document::margin_left,
-                     constants::document::default_view_height -
-                         2 * constants::document::margin_top};
-    float spacing = 0.0f;
+void Document::refresh() {
+    processWordWrap();
+    if (mSpellChecking) mSpellChecker.submit(mRope);
+}
 
-    displayPositions.clear();
+void Document::replace_ranges(const std::vector< Range >& ranges,
+                              const Rope& text) {
+    std::vector< Rope::Splice > splices;
+    splices.reserve(ranges.size());
+    for (auto [start, end] : ranges) {
+        if (start != end || text.length()) {
+            splices.push_back({start, end - start, text});
+        }
+    }
+    if (!apply(history::combine(mRope, splices))) return;
+
+    // the primary cursor stays the one in its range
+    std::size_t primary = mCursorIndex;
+    bool placed = false;
+    std::size_t inserted = 0, removed = 0;
+
+    mCursors.clear();
+    mCursors.reserve(ranges.size());
+    for (auto [start, end] : ranges) {
+        std::size_t cursor = start + inserted - removed + text.length();
+        inserted += text.length();
+        removed += end - start;
+
+        if (!placed && start <= primary && primary <= end) {
+            move_cursor(cursor);
+            placed = true;
+        } else {
+            mCursors.push_back({cursor, cursor});
+        }
+    }
+    mIsSelecting = false;
 
-    float textOffsetX = 0.0f;
-    float textOffsetY = 0.0f;
+    refresh();
+}
 
-    // Word/character wrapping mechanism variables
-    enum { MEASURE_STATE = 0, DRAW_STATE = 1 };
-    int state = wordWrap ? MEASURE_STATE : DRAW_STATE;
+void Document::move_cursor(std::size_t index) {
+    mCursorIndex = std::min(index, mRope.length());
+}
 
-    int startLine = -1;  // Index where to begin drawing (where a line begins)
-    int endLine = -1;    // Index where to stop drawing (where a line ends)
-    int lastk = -1;      // Holds last value of the character position
+Cursor Document::cursor_at(std::size_t index) const {
+    auto [line, column] = mRope.pos_from_index(index);
+    return Cursor{static_cast< int >(line), static_cast< int >(column),
+                  static_cast< int >(index)};
+}
 
-    float curLineHeight = 0.0f;
+std::string Document::journal_path() const {
+    // never shared, the journal of one untitled document would otherwise
+    // be taken over by the next
+    if (mJournalPath.empty()) mJournalPath = untitled_journal_path();
+    return mJournalPath;
+}
 
-    for (int i = 0, k = 0; i < length; i++, k++) {
-        Font charFont = getFont(content[i]);
-        const char* charText = content[i].getChar();
+void Document::recover() {
+    // the last session ended with edits it did not save
+    if (auto recovered = io::Journal::recover(journal_path())) {
+        mRope = *recovered;
+        mCursorIndex = 0;
 
-        // Vector2 charSize =
-        //     utils::measure_text(charFont, content[i].getChar(), 36, 2);
-        std::size_t charFontSize = content[i].getFontSize();
+        // owned from now on, so saving or closing unmodified discards it
+        mJournal = std::make_unique< io::Journal >(journal_path(), mRope);
+    }
+}
 
-        if (content[i].isSuperscript() || content[i].isSubscript()) {
-            charFontSize /= 2;
-        }
+bool Document::recover(const std::string& path) {
+    auto recovered = io::Journal::recover(path);
+    if (!recovered) return false;
+
+    close_journal();
+    mRope = *recovered;
+    mIndexer.reset();
+    mFilename = "Untitled";
+    mFormat = io::Format::Text;
+    // never saved
+    mSavedRoot = nullptr;
+    mSaveError.clear();
+    mSpellChecking = true;
+
+    // moved under a name of this editor, which no other one takes for an
+    // orphan, once it is safely there
+    mJournalPath.clear();
+    mJournal = std::make_unique< io::Journal >(journal_path(), mRope);
+    mJournal->wait_idle();
+    if (mJournal->error().empty()) io::Journal::remove(path);
+
+    mCursorIndex = 0;
+    clear_cursors();
+    turn_off_selecting();
+    mHistory->clear();
+
+    refresh();
+    return true;
+}
 
-        float scaleFactor = charFontSize / (float)charFont.baseSize;
+std::vector< std::string > Document::orphaned_journals() {
+    std::vector< std::string > journals;
 
-        curLineHeight =
-            std::max(curLineHeight,
-                     (charFont.baseSize + charFont.baseSize / 2) * scaleFactor);
+    std::error_code error;
+    std::filesystem::directory_iterator it(state_directory(), error);
+    for (; !error && it != std::filesystem::directory_iterator();
+         it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (is_orphaned(name)) journals.push_back(it->path().string());
+    }
 
-        // Get next codepoint from byte string and glyph index in font
-        int codepointByteCount = 0;
-        int codepoint = GetCodepoint(charText, &codepointByteCount);
-        int index = GetGlyphIndex(charFont, codepoint);
+    std::sort(journals.begin(), journals.end());
+    return journals;
+}
 
-        if (codepoint == 0x3f) codepointByteCount = 1;
-        codepointByteCount = 1;
-        i += (codepointByteCount - 1);
+void Document::check_journal() {
+    if (!mJournal) return;
 
-        float glyphWidth = 0;
-        if (codepoint != '\n') {
-            glyphWidth = (charFont.glyphs[index].advanceX == 0)
-                             ? charFont.recs[index].width * scaleFactor
-                             : charFont.glyphs[index].advanceX * scaleFactor;
+    std::string error = mJournal->error();
+    if (error.empty()) {
+        // the reset after the error wrote its snapshot
+        if (mJournal->compactions() > mJournalResetAt) mJournalError.clear();
+        return;
+    }
 
-            if (i + 1 < length) glyphWidth = glyphWidth + spacing;
-        }
+    // the journal stopped writing, start it over from the document, not
+    // on every frame while the disk is failing
+    mJournalError = "Autosave failed: " + error;
+    auto now = std::chrono::steady_clock::now();
+    if (now - mJournalRetry < constants::document::journal_retry) return;
 
-        if (state == MEASURE_STATE) {
-            if ((codepoint == ' ') || (codepoint == '\t') ||
-                (codepoint == '\n'))
-                endLine = i;
-
-            if ((textOffsetX + glyphWidth) > rec.width) {
-                endLine = (endLine < 1) ? i : endLine;
-                if (i == endLine) endLine -= codepointByteCount;
-                if ((startLine + codepointByteCount) == endLine)
-                    endLine = (i - codepointByteCount);
-
-                state = !state;
-            } else if ((i + 1) == length) {
-                endLine = i;
-                state = !state;
-            } else if (codepoint == '\n')
-                state = !state;
-
-            if (state == DRAW_STATE) {
-                textOffsetX = 0;
-                i = startLine;
-                glyphWidth = 0;
-
-                // Save character position when we switch states
-                int tmp = lastk;
-                lastk = k - 1;
-                k = tmp;
-            }
-        } else {
-            if (codepoint == '\n') {
-                displayPositions.push_back({textOffsetX, textOffsetY});
-            } else {
-                // When text overflows rectangle height limit, just stop
-                // drawing
-                if ((textOffsetY + charFont.baseSize * scaleFactor) >
-                    rec.height)
-                    break;
-
-                int offsetY = charFont.baseSize * scaleFactor;
-
-                displayPositions.push_back({
-                    textOffsetX, textOffsetY
-                    // + (content[i].isSubscript() ? offsetY : 0)
-                });
-            }
+    mJournalRetry = now;
+    mJournalResetAt = mJournal->compactions();
+    mJournal->reset(mRope);
+}
 
-            if (wordWrap && (i == endLine)) {
-                textOffsetY += curLineHeight;
-                // textOffsetY +=
-                //     (charFont.baseSize + charFont.baseSize / 2) *
-                //     scaleFactor;
-                textOffsetX = 0;
-                startLine = endLine;
-                endLine = -1;
-                glyphWidth = 0;
-                k = lastk;
+const std::string& Document::journal_error() const { return mJournalError; }
 
-                state = !state;
+void Document::close_journal() {
+    if (!mJournal) return;
 
-                curLineHeight = 0.0f;
-            }
-        }
+    if (!is_modified()) mJournal->discard();
+    mJournal.reset();
+}
 
-        if ((textOffsetX != 0) || (codepoint != ' '))
-            textOffsetX += glyphWidth;  // avoid leading spaces
+void Document::processWordWrap() {
+    PROFILE_SCOPE("Document::processWordWrap");
+
+    // a document opened before the fonts are set is laid out on the first
+    // refresh after
+    if (!mMetrics) return;
+
+    Vector2 page = {constants::document::default_view_width -
+                        2 * constants::document::margin_left,
+                    constants::document::default_view_height -
+                        2 * constants::document::margin_top};
+
+    // only the first page is laid out, so flatten just enough of the rope to
+    // fill it instead of the whole document. A page is far below a batch of
+    // layout::wrap_paragraphs, so laying it out in parallel would not help.
+    std::size_t prefix = 4096;
+    while (!layout::wrap(mRope.subnstr(0, prefix) + nstring("?"), *mMetrics,
+                         page, mPositions) &&
+           prefix < mRope.length()) {
+        prefix *= 2;
     }
-}
\ No newline at end of file
+}
@@ -1,39 +1,111 @@
 #ifndef DOCUMENT_HPP
 #define DOCUMENT_HPP
 
+#include <chrono>
+#include <memory>
 #include <optional>
 
-#include "DocumentFont.hpp"
 #include "FontFactory.hpp"
 #include "cursor.hpp"
 #include "dictionary/dictionary.hpp"
+#include "history/snapshot_history.hpp"
+#include "io/journal.hpp"
+#include "io/mapped_text.hpp"
+#include "io/saver.hpp"
+#include "layout/glyph_metrics.hpp"
+#include "layout/positions.hpp"
+#include "outline/outline.hpp"
 #include "raylib.h"
 #include "rope/rope.hpp"
+#include "search/search.hpp"
+#include "spellcheck/spellchecker.hpp"
+#include "text/style.hpp"
 
 class Document {
 public:
+    // [start, end) indices into the text
+    using Range = std::pair< std::size_t, std::size_t >;
+
+    // An untitled document starts empty. A file is opened with the unsaved
+    // edits journaled for it, if any.
     Document();
     Document(std::string filename);
+    ~Document();
+
+    // Replace the content with a native document or a UTF-8 text file,
+    // throws std::runtime_error if it cannot be read. Text files past
+    // constants::document::mapped_threshold are memory-mapped and stay
+    // read-only until indexed in the background.
+    void open(const std::string& filename);
+
+    // Replace the content with an untitled document holding what the
+    // journal at `path` holds, e.g. one of a session that crashed. The
+    // journal is taken over. Returns false if there is no journal.
+    bool recover(const std::string& path);
+    // Journals of untitled documents whose editor is no longer running
+    static std::vector< std::string > orphaned_journals();
+
+    // Called every frame, picks up the result of background work.
+    void update();
+
+    // Write the current text to filename() on the background writer, the
+    // document stays editable meanwhile, in the format it was opened in.
+    // Returns false if nothing was queued (a read-only document is saved
+    // once it is indexed).
+    bool save();
+    // Same as save(), after renaming the document. Names ending in
+    // constants::document::native_extension are saved in the native format.
+    bool save_as(const std::string& filename);
+
+    // A save is queued or being written
+    bool is_saving() const;
+    // The text differs from the last one saved or opened
+    bool is_modified() const;
+    // Error of the last save, empty if it succeeded
+    const std::string& save_error() const;
+    // Error of the journal of unsaved edits, empty once it writes again
+    const std::string& journal_error() const;
+
+    bool is_read_only() const;
+    // Progress of the background index of a mapped file, if one is running
+    std::optional< io::MappedText::Progress > indexing_progress() const;
 
     void set_font_factory(FontFactory* fonts);
-    void set_document_fonts(DocumentFont* docFonts);
+    // The text is laid out with these, not at all until they are set
+    void set_glyph_metrics(const layout::GlyphMetrics* metrics);
 
     void set_dictionary(Dictionary* dictionary);
 
     Rope& rope();
     const Rope& rope() const;
 
-    Cursor& cursor();
+    // The cursor is kept as an index into the text; its line and column are
+    // worked out when asked for and cached until the index or text changes.
     const Cursor& cursor() const;
+    std::size_t cursor_index() const;
     void set_cursor(Cursor cursor);
+    void set_cursor_index(std::size_t index);
 
     std::string& filename();
     const std::string& filename() const;
 
-    Cursor& select_orig();
-    const Cursor& select_orig() const;
-    const Cursor& select_start() const;
-    const Cursor& select_end() const;
+    // [start, end) of the selection, empty at the cursor if there is none
+    Range selection() const;
+    Cursor select_start() const;
+    Cursor select_end() const;
+
+    // Extra cursors, each with its own selection. Typing, erasing and
+    // pasting change the text at all of them as one edit; moving the cursor
+    // goes back to the primary one alone.
+    void add_cursor(std::size_t index);
+    void add_selection(Range range);
+    // Selects every match of the last search of this text, the first one as
+    // the primary selection
+    void select_matches(const Search& search);
+    void clear_cursors();
+    std::size_t cursor_count() const;
+    // The primary selection and the extra ones, sorted, overlaps merged
+    std::vector< Range > selections() const;
 
     void cursor_move_line(int delta);
 
@@ -46,25 +118,31 @@ public:
     void cursor_move_next_word();
     void cursor_move_prev_word();
 
-    Cursor pos_on_mouse() const;
+    std::size_t index_on_mouse() const;
 
     void insert_at_cursor(const nstring& text);
+    void insert_at_cursor(const Rope& text);
     void append_at_cursor(const nstring& text);
     void erase_at_cursor();
     void erase_selected();
     void erase_range(std::size_t start, std::size_t end);
     void copy_selected();
     void copy_range(std::size_t start, std::size_t end);
+    // Insert the clipboard text at the cursor
+    void paste();
 
-    void save_snapshot();
     void undo();
     void redo();
+    UndoBackend& history();
+    // Replaces the undo history, the current one is discarded.
+    void set_undo_backend(std::unique_ptr< UndoBackend > backend);
     // std::optional< Rope > undo_top();
-    // void save();
-    // void save_as();
 
     Vector2 get_display_positions(std::size_t index) const;
+    // Number of characters from the start that have a display position
+    std::size_t laid_out_length() const;
 
+    // Starts a selection anchored at the cursor
     void turn_on_selecting();
     void turn_off_selecting();
     bool is_selecting() const;
@@ -73,9 +151,13 @@ public:
     bool check_word_at_cursor();
     std::vector< nstring > suggest_at_cursor();
 
+    // latest ranges published by the background spell checker
+    const std::vector< SpellChecker::Range >& misspelled_ranges();
+
 public:
-    // pair< heading type, heading text >
-    std::vector< std::pair< std::size_t, nstring > > get_outline() const;
+    // Headings of the text, by position. Kept up to date by every edit,
+    // read again after the text is replaced (open, undo, redo).
+    const std::vector< Outline::Heading >& get_outline() const;
 
 public:
     void underline_selected();
@@ -112,31 +194,89 @@ public:
     std::string get_link_selected() const;
 
 private:
+    // Every change of the text goes through here, so it is recorded.
+    // Returns false if nothing was changed.
+    bool apply(const history::Edit& edit);
+    void refresh();
+
+    // After an undo or redo moved the text from `before` to its state now
+    void restore(const Rope& before, const Cursor& restored);
+
+    // Replaces every range with text in one edit, leaving an extra cursor
+    // after each replacement. The ranges are sorted and do not overlap.
+    void replace_ranges(const std::vector< Range >& ranges, const Rope& text);
+
+    // Restyles [start, end) as one edit without copying its text
+    void restyle(std::size_t start, std::size_t end, const StylePatch& patch);
+    void toggle_type(std::size_t start, std::size_t end, nchar::Type type);
+
+    // Moves the cursor without ending the current typing run
+    void move_cursor(std::size_t index);
+    Cursor cursor_at(std::size_t index) const;
+
+    // Next to the file, or a path of its own for an untitled document
+    std::string journal_path() const;
+    // Replace the content with what the journal of the file holds
+    void recover();
+    // Starts the journal over after it failed to write
+    void check_journal();
+    // Keeps the journal files only if there is unsaved work in them
+    void close_journal();
+
+    // With constants::document::persistent_undo, the operation log is saved
+    // next to the file and restored when the same text is opened again
+    std::string undo_path() const;
+    void save_undo();
+    void load_undo();
+
     void processWordWrap();
-    // void processWordWrap2();
 
 private:
-    struct Snapshot {
-        Rope rope;
-        Cursor cursor;
-    };
     Rope mRope{};
 
-    std::vector< Snapshot > mUndo{};
-    std::vector< Snapshot > mRedo{};
-
-    Cursor mCursor{};
-    Cursor mSelectOrig{-1, -1};
-
-    std::vector< Vector2 > displayPositions{};
-    std::vector< bool > validWords{};
+    std::unique_ptr< UndoBackend > mHistory{
+        std::make_unique< SnapshotHistory >()};
+
+    std::size_t mCursorIndex{0};
+    std::size_t mSelectAnchor{0};
+    // line and column of mCursorIndex in the rope with root mCursorRoot
+    mutable Cursor mCursor{};
+    mutable Rope::Ptr mCursorRoot{};
+    // sorted by start
+    std::vector< Range > mCursors{};
+
+    std::unique_ptr< io::MappedText > mIndexer{};
+
+    // headings of the rope with root mOutlineRoot
+    mutable Outline mOutline{};
+    mutable Rope::Ptr mOutlineRoot{};
+
+    // root of the rope last saved or opened, to tell if it was modified
+    Rope::Ptr mSavedRoot{};
+    std::string mSaveError{};
+    io::Format mFormat{io::Format::Text};
+    io::Saver mSaver{};
+
+    // started on the first edit, every later one is appended
+    std::unique_ptr< io::Journal > mJournal{};
+    std::string mJournalError{};
+    // when the journal was last started over, and its snapshots by then
+    std::chrono::steady_clock::time_point mJournalRetry{};
+    std::size_t mJournalResetAt{0};
+
+    layout::Positions mPositions{};
+    bool mSpellChecking{true};
+    SpellChecker mSpellChecker{};
+    std::vector< SpellChecker::Range > mMisspelled{};
 
     std::string mFilename{"Untitled"};
+    // chosen on first use for an untitled document
+    mutable std::string mJournalPath{};
 
-    Dictionary* mDictionary;
+    Dictionary* mDictionary{};
 
-    FontFactory* mFonts;
-    DocumentFont* mDocFonts;
+    FontFactory* mFonts{};
+    const layout::GlyphMetrics* mMetrics{};
 
     bool mIsSelecting{false};
 
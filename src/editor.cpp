@@ -2,13 +2,19 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <locale>
+#include <optional>
 #include <set>
 #include <vector>
 
 #include "clip.h"
 #include "constants.hpp"
+#include "profile/profiler.hpp"
 #include "raygui.h"
 #include "rope/rope.hpp"
 #include "utils.hpp"
@@ -24,19 +30,36 @@ void Editor::Init() {
     LoadResources();
 
     currentDocument().set_font_factory(fonts);
-    currentDocument().set_document_fonts(mDocumentFont);
+    currentDocument().set_glyph_metrics(&mMetrics);
 
     currentDocument().set_dictionary(mDictionary);
 
     mDocumentFont->set_font_factory(fonts);
     PrepareKeybinds();
+
+    mOrphans = Document::orphaned_journals();
+    if (!mOrphans.empty()) SetPage(EditorPage::Recover);
 }
 
 bool Editor::WindowClosed() { return closed; }
 
-void Editor::Close() { CloseWindow(); }
+void Editor::Close() {
+    // the tiles are textures of the window
+    mTiles.clear();
+    CloseWindow();
+}
+
+void Editor::Open(const std::string& filename) {
+    try {
+        currentDocument().open(filename);
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+    }
+}
 
 void Editor::Run() {
+    PROFILE_SCOPE("Frame");
+
     /* render */
     Update(GetFrameTime());
     Render();
@@ -47,6 +70,8 @@ void Editor::Run() {
 }
 
 void Editor::Render() {
+    PROFILE_SCOPE("Editor::Render");
+
     BeginDrawing();
 
     DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
@@ -58,6 +83,8 @@ void Editor::Render() {
 
     DrawPage();
 
+    if (mShowProfile) DrawProfile();
+
     EndDrawing();
 }
 
@@ -66,6 +93,10 @@ std::vector< int > s;
 // Rope tmp;
 
 void Editor::Update([[maybe_unused]] float dt) {
+    PROFILE_SCOPE("Editor::Update");
+
+    currentDocument().update();
+
     switch (mMode) {
         case EditorMode::Normal:
             NormalMode();
@@ -92,20 +123,77 @@ void Editor::DrawEditor() {
                   margin_top, documentWidth, documentHeight, WHITE);
 
     DrawEditorText();
+    DrawStatus();
 }
 
-void Editor::DrawEditorText() {
-    auto getFont = [&](const nchar& c) -> Font {
-        if (c.isBold() && c.isItalic()) {
-            return mDocumentFont->get_bold_italic_font(c.getFontId());
-        } else if (c.isBold()) {
-            return mDocumentFont->get_bold_font(c.getFontId());
-        } else if (c.isItalic()) {
-            return mDocumentFont->get_italic_font(c.getFontId());
-        }
-        return mDocumentFont->get_font(c.getFontId());
+void Editor::DrawProfile() {
+    std::vector< profile::Profiler::Stat > stats = profile::profiler().stats();
+
+    float font_size = 18, row_height = 22;
+    Rectangle box{(float)GetScreenWidth() - 470, 10, 460,
+                  (stats.size() + 1) * row_height + 10};
+    DrawRectangleRec(box, ColorAlpha(BLACK, 0.7f));
+
+    auto draw_row = [&](std::size_t row, const std::string& name,
+                        const std::string& p50, const std::string& p99,
+                        const std::string& count) {
+        float y = box.y + 5 + row * row_height;
+        Font font = fonts->Get("Arial");
+        DrawTextEx(font, name.c_str(), Vector2{box.x + 8, y}, font_size, 0,
+                   WHITE);
+        DrawTextEx(font, p50.c_str(), Vector2{box.x + 260, y}, font_size, 0,
+                   WHITE);
+        DrawTextEx(font, p99.c_str(), Vector2{box.x + 330, y}, font_size, 0,
+                   WHITE);
+        DrawTextEx(font, count.c_str(), Vector2{box.x + 400, y}, font_size, 0,
+                   WHITE);
+    };
+
+    auto ms = [](double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.2f", value);
+        return std::string(text);
     };
 
+    draw_row(0, "scope (ms)", "p50", "p99", "count");
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        draw_row(i + 1, std::string(stats[i].name), ms(stats[i].p50),
+                 ms(stats[i].p99), std::to_string(stats[i].count));
+    }
+}
+
+void Editor::DrawStatus() {
+    const Document& document = currentDocument();
+    std::string status;
+
+    if (auto progress = document.indexing_progress()) {
+        // the line count is extrapolated until the whole file is indexed
+        std::size_t percent =
+            progress->totalBytes
+                ? progress->bytes * 100 / progress->totalBytes
+                : 100;
+        status = "Indexing " + std::to_string(percent) + "% - about " +
+                 std::to_string(progress->estimatedLines) +
+                 " lines (read-only)";
+    } else if (document.is_saving()) {
+        status = "Saving " + document.filename() + "...";
+    } else if (!document.save_error().empty()) {
+        status = document.save_error();
+    } else if (!document.journal_error().empty()) {
+        status = document.journal_error();
+    } else if (document.is_modified()) {
+        status = document.filename() + " (modified)";
+    }
+    if (status.empty()) return;
+
+    DrawTextEx(fonts->Get("Arial"), status.c_str(),
+               Vector2{10, (float)GetScreenHeight() - 30}, 20, 0,
+               Color{95, 99, 104, 255});
+}
+
+void Editor::DrawEditorText() {
+    PROFILE_SCOPE("Editor::DrawEditorText");
+
     int documentWidth = constants::document::default_view_width;
     int documentHeight = constants::document::default_view_height;
     int margin_top = constants::document::margin_top;
@@ -118,116 +206,243 @@ void Editor::DrawEditorText() {
     std::size_t line_start = content.find_line_start(cur_line_idx);
     std::size_t next_line_start;
 
-    for (; cur_line_idx < content.line_count();
+    // only the laid out part of the document has positions to draw at
+    std::size_t laid_out = currentDocument().laid_out_length();
+    std::vector< Document::Range > selections =
+        currentDocument().selections();
+
+    auto bits = [](float value) {
+        return std::bit_cast< std::uint32_t >(value);
+    };
+
+    // characters of a line drawn with one call
+    struct Run {
+        std::size_t style;  // index of its first character in the line
+        std::size_t first;  // of its codepoints in `codepoints`
+        std::size_t count;
+        Vector2 pos;
+        float width;
+    };
+    std::vector< Run > runs;
+    std::vector< int > codepoints;
+
+    for (; cur_line_idx < content.line_count() && line_start < laid_out;
          cur_line_idx++, line_start = next_line_start) {
         next_line_start = content.find_line_start(cur_line_idx + 1);
 
+        // every glyph of Arial at 36 measures as tall as the font
         float line_height = 0;
-        float y = currentDocument().get_display_positions(line_start).y;
+        if (next_line_start - line_start > 1) {
+            line_height =
+                utils::measure_text(fonts->Get("Arial"), "A", 36, 2).y;
+        }
 
-        for (std::size_t i = line_start; i < next_line_start - 1; ++i) {
-            Vector2 charSize = utils::measure_text(fonts->Get("Arial"),
-                                                   content[i].getChar(), 36, 2);
-            line_height = std::max(line_height, charSize.y);
+        // the line is read once, a lookup per character would walk the tree
+        nstring text =
+            content.subnstr(line_start, next_line_start - line_start);
+
+        // cut the line into runs: characters in a row sharing a style are
+        // drawn with one call. The layout advances glyphs the way
+        // DrawTextCodepoints does, so a run only needs the position of its
+        // first character; where the layout does not advance (leading
+        // spaces of a row) the run ends.
+        runs.clear();
+        codepoints.clear();
+        for (std::size_t begin = 0, end; begin < text.length(); begin = end) {
+            const nchar& style = text[begin];
+            Vector2 pos = currentDocument().get_display_positions(line_start +
+                                                                  begin);
+            Vector2 last = pos;
+
+            std::size_t first = codepoints.size();
+            for (end = begin; end < text.length(); ++end) {
+                Vector2 next =
+                    currentDocument().get_display_positions(line_start + end);
+                bool continues = end == begin || (next.y == pos.y &&
+                                                  next.x > last.x &&
+                                                  text[end].sameStyle(style));
+                if (!continues || text[end].codepoint() == '\n') break;
+
+                codepoints.push_back(text[end].codepoint());
+                last = next;
+            }
+            if (codepoints.size() == first) {
+                ++end;
+                continue;
+            }
+
+            float fontSize = style.getFontSize();
+            if (style.isSuperscript() || style.isSubscript()) fontSize /= 2;
+
+            // up to where the next character starts, or past the last glyph
+            Vector2 after =
+                currentDocument().get_display_positions(line_start + end);
+            float width = after.y == pos.y && end < text.length()
+                              ? after.x - pos.x
+                              : last.x - pos.x +
+                                    mMetrics.advance(
+                                        nchar(codepoints.back(), style),
+                                        fontSize);
+
+            runs.push_back(
+                {begin, first, codepoints.size() - first, pos, width});
         }
+        if (runs.empty()) continue;
+
+        // the tile of the line, keyed by what it looks like
+        float top = runs.front().pos.y, bottom = top, right = 0;
+        TileCache::Key key = 0;
+        for (const Run& run : runs) {
+            const nchar& style = text[run.style];
+            key = TileCache::mix(key, style.getType());
+            key = TileCache::mix(key, style.getFontSize());
+            key = TileCache::mix(key, style.getFontId());
+            key = TileCache::mix(key, ColorToInt(style.getColor()));
+            key = TileCache::mix(key, ColorToInt(style.getBackgroundColor()));
+            key = TileCache::mix(key,
+                                 std::hash< std::string >{}(style.getLink()));
+
+            key = TileCache::mix(key, bits(run.pos.x));
+            key = TileCache::mix(key, bits(run.pos.y - top));
+            key = TileCache::mix(key, bits(run.width));
+            key = TileCache::mix(key, run.count);
+            for (std::size_t i = 0; i < run.count; ++i) {
+                key = TileCache::mix(key, codepoints[run.first + i]);
+            }
 
-        // draw text
-        for (std::size_t i = line_start; i < next_line_start; ++i) {
-            Font charFont = getFont(content[i]);
-            std::size_t charFontSize = content[i].getFontSize();
-            Color textColor = content[i].getColor();
-            Color backgroundColor = content[i].getBackgroundColor();
+            // subscripts sit a font size lower, underlines below the glyphs
+            float fontSize = style.getFontSize();
+            if (style.isSuperscript() || style.isSubscript()) fontSize /= 2;
+            float depth = style.isSubscript() ? 2 * fontSize : fontSize;
 
-            bool hasLink = content[i].hasLink();
+            bottom = std::max(bottom, run.pos.y + depth + 2);
+            right = std::max(right, run.pos.x + run.width + 2);
+        }
 
-            if (hasLink) textColor = BLUE;
+        auto paint = [&](Vector2 origin) {
+            for (const Run& run : runs) {
+                const nchar& style = text[run.style];
+                Font font = mMetrics.font(style);
+                float fontSize = style.getFontSize();
+                Color textColor = style.hasLink() ? BLUE : style.getColor();
+                Color backgroundColor = style.getBackgroundColor();
 
-            Vector2 pos = currentDocument().get_display_positions(i);
-            Vector2 charSize = utils::measure_text(
-                charFont, content[i].getChar(), charFontSize, 2);
+                if (style.isSuperscript() || style.isSubscript()) {
+                    fontSize /= 2;
+                }
 
-            if (content[i].isSuperscript() || content[i].isSubscript()) {
-                charSize.x /= 2, charSize.y /= 2;
-                charFontSize /= 2;
-            }
+                Vector2 rendered_pos = {origin.x + run.pos.x,
+                                        origin.y + run.pos.y - top};
+                if (style.isSubscript()) rendered_pos.y += fontSize;
+
+                // unstyled backgrounds are the white of the page
+                bool background =
+                    backgroundColor.a != 0 &&
+                    ColorToInt(backgroundColor) != ColorToInt(WHITE);
+                if (background) {
+                    DrawRectangle(rendered_pos.x, rendered_pos.y, run.width,
+                                  fontSize, backgroundColor);
+                }
 
-            if (content[i].isSubscript()) {
-                pos.y += charSize.y;
-            }
+                DrawTextCodepoints(font, codepoints.data() + run.first,
+                                   run.count, rendered_pos, fontSize, 0,
+                                   textColor);
 
-            // draw background
-            DrawRectangle(utils::sum(utils::get_init_pos(), pos).x,
-                          utils::sum(utils::get_init_pos(), pos).y, charSize.x,
-                          charSize.y, backgroundColor);
-
-            DrawTextEx(charFont, content[i].getChar(),
-                       utils::sum(utils::get_init_pos(), pos), charFontSize, 2,
-                       textColor);
-
-            if (content[i].isUnderline()) {
-                DrawLineEx(
-                    utils::sum(utils::get_init_pos(),
-                               Vector2{pos.x, pos.y + charSize.y}),
-                    utils::sum(utils::get_init_pos(),
-                               Vector2{pos.x + charSize.x, pos.y + charSize.y}),
-                    1.5f, textColor);
-            }
+                float run_end = rendered_pos.x + run.width;
+                if (style.isUnderline()) {
+                    float underline_y = rendered_pos.y + fontSize;
+                    DrawLineEx(Vector2{rendered_pos.x, underline_y},
+                               Vector2{run_end, underline_y}, 1.5f,
+                               textColor);
+                }
 
-            if (content[i].isStrikethrough()) {
-                DrawLineEx(
-                    utils::sum(utils::get_init_pos(),
-                               Vector2{pos.x, pos.y + 2 * charSize.y / 3}),
-                    utils::sum(utils::get_init_pos(),
-                               Vector2{pos.x + charSize.x,
-                                       pos.y + 2 * charSize.y / 3}),
-                    1.5f, textColor);
+                if (style.isStrikethrough()) {
+                    float strike_y = rendered_pos.y + 2 * fontSize / 3;
+                    DrawLineEx(Vector2{rendered_pos.x, strike_y},
+                               Vector2{run_end, strike_y}, 1.5f, textColor);
+                }
             }
+        };
+
+        // lines are redrawn only when they change, or when the driver has
+        // no render textures
+        Vector2 tile_pos = utils::sum(utils::get_init_pos(), Vector2{0, top});
+        if (!mTiles.draw(key, std::ceil(right), std::ceil(bottom - top),
+                         tile_pos, paint, WHITE)) {
+            paint(tile_pos);
         }
 
-        // draw selected chars
-        if (currentDocument().is_selecting()) {
-            const auto& select_start = currentDocument().select_start();
-            const auto& select_end = currentDocument().select_end();
-
-            std::size_t select_start_idx =
-                content.index_from_pos(select_start.line, select_start.column);
-            std::size_t select_end_idx =
-                content.index_from_pos(select_end.line, select_end.column);
-
-            if (select_start.line <= cur_line_idx &&
-                select_end.line >= cur_line_idx) {
-                std::size_t start = std::max(select_start_idx, line_start);
-                std::size_t end = std::min(select_end_idx, next_line_start - 1);
-
-                for (std::size_t i = start; i < end; ++i) {
-                    Font charFont = getFont(content[i]);
-                    std::size_t charFontSize = content[i].getFontSize();
-
-                    Vector2 pos = currentDocument().get_display_positions(i);
-                    Vector2 charSize = utils::measure_text(
-                        charFont, content[i].getChar(), charFontSize, 2);
-
-                    if (content[i].isSuperscript() ||
-                        content[i].isSubscript()) {
-                        charSize.x /= 2, charSize.y /= 2;
-                        charFontSize /= 2;
-                    }
-
-                    Vector2 rendered_pos =
-                        utils::sum(utils::get_init_pos(), pos);
-
-                    DrawRectangle(rendered_pos.x, rendered_pos.y,
-                                  charSize.x + 1, line_height,
-                                  ColorAlpha(GRAY, 0.3F));
-                    //   Color{109, 158, 235, 255});
+        // draw selections, of every cursor that has one, as a rectangle per
+        // row: the runs already know where each row starts and ends
+        auto x_at = [&](std::size_t i) {
+            return currentDocument().get_display_positions(line_start + i).x;
+        };
+        Vector2 init_pos = utils::get_init_pos();
+        auto highlight = [&](const Rectangle& row) {
+            DrawRectangleRec(Rectangle{init_pos.x + row.x, init_pos.y + row.y,
+                                       row.width + 1, row.height},
+                             ColorAlpha(GRAY, 0.3F));
+        };
+
+        auto selected = std::lower_bound(
+            selections.begin(), selections.end(), line_start,
+            [](const Document::Range& range, std::size_t index) {
+                return range.second < index;
+            });
+        for (; selected != selections.end() &&
+               selected->first < next_line_start;
+             ++selected) {
+            // relative to the line, without its line feed
+            std::size_t start = std::max(selected->first, line_start) -
+                                line_start;
+            std::size_t end =
+                std::min(selected->second, next_line_start - 1) - line_start;
+            if (start >= end) continue;
+
+            std::optional< Rectangle > row;
+            for (const Run& run : runs) {
+                std::size_t run_end = run.style + run.count;
+                if (run_end <= start || run.style >= end) continue;
+
+                float from = run.style >= start ? run.pos.x : x_at(start);
+                float to = run_end <= end ? run.pos.x + run.width : x_at(end);
+
+                if (row && row->y == run.pos.y) {
+                    row->width = to - row->x;
+                    continue;
                 }
+                if (row) highlight(*row);
+                row = Rectangle{from, run.pos.y, to - from, line_height};
             }
+            if (row) highlight(*row);
+        }
+    }
+
+    // mark misspelled words reported by the background spell checker
+    for (const auto& range : currentDocument().misspelled_ranges()) {
+        if (range.start >= laid_out) continue;
+        std::size_t end = std::min(range.start + range.length, laid_out);
+        nstring word = content.subnstr(range.start, end - range.start);
+
+        for (std::size_t i = range.start; i < end; ++i) {
+            const nchar& c = word[i - range.start];
+            float fontSize = c.getFontSize();
+            Vector2 pos = currentDocument().get_display_positions(i);
+            Vector2 next = currentDocument().get_display_positions(i + 1);
+
+            // the last character of a line has no neighbour to measure to
+            float width = next.y == pos.y ? next.x - pos.x
+                                          : mMetrics.advance(c, fontSize);
+
+            utils::DrawSquiggle(
+                utils::sum(utils::get_init_pos(),
+                           Vector2{pos.x, pos.y + fontSize}),
+                width, RED);
         }
     }
 
     // draw cursor block
-    std::size_t cursor_pos = currentDocument().rope().index_from_pos(
-        currentDocument().cursor().line, currentDocument().cursor().column);
+    std::size_t cursor_pos = currentDocument().cursor_index();
     Vector2 cursor_display_pos =
         currentDocument().get_display_positions(cursor_pos);
 
@@ -236,27 +451,41 @@ void Editor::DrawEditorText() {
 
     DrawRectangle(cursor_rendered_pos.x, cursor_rendered_pos.y, 1.5f, 36,
                   ORANGE);
+
+    // the extra cursors sit at the end of their ranges
+    for (const auto& [start, end] : selections) {
+        if (end == cursor_pos || end > laid_out) continue;
+
+        Vector2 display_pos = currentDocument().get_display_positions(end);
+        Vector2 rendered_pos = utils::sum(utils::get_init_pos(), display_pos);
+        DrawRectangle(rendered_pos.x, rendered_pos.y, 1.5f, 36, ORANGE);
+    }
 }
 
 void Editor::NormalMode() {}
 
 void Editor::InsertMode() {
-    static bool leftMousePrevDown = false;
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        Cursor cursor = currentDocument().pos_on_mouse();
+    PROFILE_SCOPE("Editor::InsertMode");
 
-        currentDocument().set_cursor(cursor);
+    static bool leftMousePrevDown = false;
+    if (IsKeyDown(KEY_LEFT_ALT)) {
+        // alt+click adds a cursor, keeping the others; holding the button
+        // does not start a selection that would move the main cursor
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            currentDocument().add_cursor(currentDocument().index_on_mouse());
+        }
+        leftMousePrevDown = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    } else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        currentDocument().set_cursor_index(currentDocument().index_on_mouse());
         currentDocument().turn_off_selecting();
     } else {
         if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
             if (!leftMousePrevDown) {
                 currentDocument().turn_on_selecting();
-                currentDocument().select_orig() = currentDocument().cursor();
             }
             if (currentDocument().is_selecting()) {
-                Cursor cursor = currentDocument().pos_on_mouse();
-
-                currentDocument().set_cursor(cursor);
+                currentDocument().set_cursor_index(
+                    currentDocument().index_on_mouse());
 
                 setLinkPage(currentDocument().get_link_selected());
             }
@@ -267,20 +496,18 @@ void Editor::InsertMode() {
 
     // IsMouseButtonDown
 
-    int key = GetCharPressed();
-    if (!key) return;
-
-    currentDocument().turn_off_selecting();
-
-    if (key == '\n') {
-        currentDocument().insert_at_cursor(nstring(nchar(key)));
-        currentDocument().cursor_move_line(1);
+    // drain everything typed since the last frame, so a burst (a paste, an
+    // IME commit, fast typing at a low frame rate) costs one insert, one
+    // layout and one undo entry instead of one per frame
+    nstring typed;
+    for (int key = GetCharPressed(); key; key = GetCharPressed()) {
+        currentDocument().turn_off_selecting();
 
-        return;
+        // characters arrive already composed, a newline is just another one
+        typed += nchar(key);
     }
 
-    if (key >= 128) currentDocument().erase_at_cursor();
-    currentDocument().insert_at_cursor(nstring(nchar(key)));
+    if (typed.length()) currentDocument().insert_at_cursor(typed);
 }
 
 void Editor::SearchMode() {}
@@ -290,6 +517,8 @@ Document& Editor::currentDocument() { return mDocument; }
 const Document& Editor::currentDocument() const { return mDocument; }
 
 void Editor::DrawOutline() {
+    PROFILE_SCOPE("Editor::DrawOutline");
+
     float documentWidth = constants::document::default_view_width;
     float documentHeight = constants::document::default_view_height;
     float margin_top = constants::document::margin_top;
@@ -315,7 +544,7 @@ void Editor::DrawOutline() {
                Color{95, 99, 104, 255});
 
     // draw outline
-    std::vector< std::pair< std::size_t, nstring > > outline =
+    const std::vector< Outline::Heading >& outline =
         currentDocument().get_outline();
 
     const std::size_t outline_heading_start_x[6] = {
@@ -337,8 +566,8 @@ void Editor::DrawOutline() {
     };
 
     for (std::size_t i = 0; i < outline.size(); ++i) {
-        std::size_t heading_type = outline[i].first;
-        nstring heading_text = outline[i].second;
+        std::size_t heading_type = outline[i].level;
+        nstring heading_text = outline[i].text;
 
         float x = margin_left + outline_heading_start_x[heading_type];
         float y = margin_top + 20 + i * 50;
@@ -376,23 +605,14 @@ void Editor::DrawOutline() {
                     std::max(0.0f, (GetScreenWidth() - documentWidth) / 2 -
                                        margin_right - margin_left)) {
             if (mousePos.y >= margin_top + 20 &&
-                mousePos.y <= margin_top + 20 + outline.size() * 50) {
+                mousePos.y < margin_top + 20 + outline.size() * 50) {
                 std::size_t heading_idx =
                     (mousePos.y - margin_top - 20) / 50 + 1;
 
-                std::size_t heading_pos = outline[heading_idx - 1]
-                                              .second.substr(0, 1)
-                                              .to_string()[0] -
-                                          '0';
-
-                std::cout << heading_idx << std::endl;
-
-                // std::size_t line_start =
-                //     currentDocument().rope().find_line_start(heading_pos -
-                //     1);
-
-                // currentDocument().set_cursor(
-                //     Cursor{static_cast< int >(line_start), 0});
+                // the cursor is an index, its line is found when drawn
+                currentDocument().set_cursor_index(
+                    outline[heading_idx - 1].index);
+                currentDocument().turn_off_selecting();
             }
         }
     }
@@ -418,6 +638,9 @@ void Editor::DrawPage() {
         case EditorPage::Color:
             DrawColorPage(initX, initY);
             break;
+        case EditorPage::Recover:
+            DrawRecoverPage(initX, initY);
+            break;
         default:
             break;
     }
@@ -461,7 +684,6 @@ void Editor::DrawLinkPage(float initX, float initY) {
         GuiButton(Rectangle{initX, initY + 200, 300, 50}, "Save Link");
     if (saveLink) {
         std::cout << currentURL << std::endl;
-        currentDocument().save_snapshot();
         currentDocument().set_link_selected(currentURL);
     }
 
@@ -490,7 +712,6 @@ void Editor::DrawColorPage(float initX, float initY) {
     bool saveColor =
         GuiButton(Rectangle{initX, initY + 780, 300, 50}, "Save Color");
     if (saveColor) {
-        currentDocument().save_snapshot();
         if (currentDocument().is_selecting()) {
             currentDocument().set_text_color_selected(currentColor);
             currentDocument().set_background_color_selected(
@@ -502,6 +723,47 @@ void Editor::DrawColorPage(float initX, float initY) {
     }
 }
 
+void Editor::DrawRecoverPage(float initX, float initY) {
+    // draw title "Recover"
+    DrawTextEx(fonts->Get("Arial"), "Recover", Vector2{initX, initY - 22}, 24,
+               0, Color{95, 99, 104, 255});
+
+    DrawLineEx(Vector2{initX, initY}, Vector2{(float)GetScreenWidth(), initY},
+               2.0f, LIGHTGRAY);
+
+    std::string message = "An untitled document was not saved when the "
+                          "editor last closed (" +
+                          std::to_string(mOrphans.size()) + " left)";
+    utils::DrawTextBoxed(fonts->Get("Arial"), message.c_str(),
+                         Rectangle{initX, initY + 20, 300, 100}, 24, 0, true,
+                         Color{95, 99, 104, 255});
+
+    bool recover =
+        GuiButton(Rectangle{initX, initY + 140, 300, 50}, "Recover");
+    bool discard =
+        GuiButton(Rectangle{initX, initY + 200, 300, 50}, "Discard");
+    if (!recover && !discard) return;
+
+    // either way the journal is not offered again: recovering moves it
+    // under this editor, discarding removes it
+    std::string journal = mOrphans.front();
+    mOrphans.erase(mOrphans.begin());
+
+    if (recover) {
+        try {
+            if (!currentDocument().recover(journal)) {
+                io::Journal::remove(journal);
+            }
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+        }
+    } else {
+        io::Journal::remove(journal);
+    }
+
+    if (mOrphans.empty()) SetPage(EditorPage::None);
+}
+
 void Editor::LoadResources() {
     fonts->Load("Arial", "assets/fonts/SVN-Arial 3.ttf");
     fonts->Load("Arial Bold", "assets/fonts/SVN-Arial 3 bold.ttf");
@@ -637,7 +899,6 @@ void Editor::PrepareKeybinds() {
         [&]() {
             if (!currentDocument().is_selecting()) {
                 currentDocument().turn_on_selecting();
-                currentDocument().select_orig() = currentDocument().cursor();
             }
             currentDocument().cursor_move_next_word();
         },
@@ -649,7 +910,6 @@ void Editor::PrepareKeybinds() {
         [&]() {
             if (!currentDocument().is_selecting()) {
                 currentDocument().turn_on_selecting();
-                currentDocument().select_orig() = currentDocument().cursor();
             }
             currentDocument().cursor_move_prev_word();
         },
@@ -660,7 +920,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_RIGHT},
         [&]() {
             currentDocument().turn_on_selecting();
-            currentDocument().select_orig() = currentDocument().cursor();
             currentDocument().cursor_move_next_word();
         },
         true);
@@ -668,10 +927,7 @@ void Editor::PrepareKeybinds() {
     // copy
     mKeybind.insert(
         {KEY_LEFT_CONTROL, KEY_C},
-        [&]() {
-            currentDocument().save_snapshot();
-            currentDocument().copy_selected();
-        },
+        [&]() { currentDocument().copy_selected(); },
         true);
 
     // cut
@@ -679,7 +935,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_X},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().copy_selected();
             currentDocument().erase_selected();
             currentDocument().turn_off_selecting();
@@ -690,15 +945,12 @@ void Editor::PrepareKeybinds() {
     mKeybind.insert(
         {KEY_LEFT_CONTROL, KEY_V},
         [&]() {
-            currentDocument().save_snapshot();
-
-            std::string text = GetClipboardText();
             if (currentDocument().is_selecting()) {
                 currentDocument().erase_selected();
                 currentDocument().turn_off_selecting();
             }
 
-            currentDocument().insert_at_cursor(text);
+            currentDocument().paste();
         },
         true);
 
@@ -708,7 +960,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_U},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().underline_selected();
         },
         true);
@@ -718,7 +969,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_F2},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().strikethrough_selected();
         },
         true);
@@ -728,7 +978,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_B},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().bold_selected();
         },
         true);
@@ -737,7 +986,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_I},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().italic_selected();
         },
         true);
@@ -747,7 +995,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_EQUAL},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().superscript_selected();
         },
         true);
@@ -757,7 +1004,6 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_MINUS},
         [&]() {
             if (!currentDocument().is_selecting()) return;
-            currentDocument().save_snapshot();
             currentDocument().subscript_selected();
         },
         true);
@@ -768,6 +1014,7 @@ void Editor::PrepareKeybinds() {
         [&]() {
             if (mMode == EditorMode::Insert) {
                 currentDocument().turn_off_selecting();
+                currentDocument().clear_cursors();
             } else if (mMode == EditorMode::Search) {
                 mMode = EditorMode::Insert;
             }
@@ -778,6 +1025,47 @@ void Editor::PrepareKeybinds() {
         {KEY_LEFT_CONTROL, KEY_F}, [&]() { mMode = EditorMode::Search; },
         false);
 
+    // a cursor on every occurrence of the selected text
+    mKeybind.insert(
+        {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_L},
+        [&]() {
+            auto [start, end] = currentDocument().selection();
+            if (start == end) return;
+
+            const Rope& content = currentDocument().rope();
+            mSearch.set_pattern(content.subrope(start, end - start));
+            mSearch.find_in_content(content);
+            currentDocument().select_matches(mSearch);
+        },
+        false);
+
+    // profiling, with the timings on screen
+    mKeybind.insert(
+        {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_P},
+        [&]() {
+            mShowProfile = !mShowProfile;
+            profile::profiler().set_enabled(mShowProfile);
+        },
+        false);
+
+    // the profiled frames as a Chrome trace, to attach to bug reports
+    mKeybind.insert(
+        {KEY_LEFT_CONTROL, KEY_LEFT_SHIFT, KEY_E},
+        [&]() {
+            const std::string path = "trace.json";
+            if (profile::profiler().write_trace(path)) {
+                std::cout << "Trace written to " << path << std::endl;
+            } else {
+                std::cerr << "Could not write " << path << std::endl;
+            }
+        },
+        false);
+
+    // save, written in the background
+    mKeybind.insert(
+        {KEY_LEFT_CONTROL, KEY_S}, [&]() { currentDocument().save(); },
+        false);
+
     mKeybind.insert(
         {KEY_LEFT_CONTROL, KEY_H},
         [&]() {
@@ -6,12 +6,14 @@
 #include "dictionary/dictionary.hpp"
 #include "document/document.hpp"
 #include "keybind/keybind.hpp"
+#include "layout/font_metrics.hpp"
 #include "raylib.h"
+#include "render/tile_cache.hpp"
 #include "search/search.hpp"
 
 enum class EditorMode { Normal, Insert, Search };
 
-enum class EditorPage { None, Link, Color };
+enum class EditorPage { None, Link, Color, Recover };
 
 /**
  * @brief The application class that represents the application.
@@ -42,6 +44,14 @@ public:
      */
     void Close();
 
+    /**
+     * @brief Open a text file in the current document.
+     * @details Errors are reported on stderr and leave the document as it
+     * was.
+     * @param filename Path of a UTF-8 text file.
+     */
+    void Open(const std::string& filename);
+
     void Init();
 
     /**
@@ -77,6 +87,10 @@ private:
 
     void DrawEditor();
     void DrawEditorText();
+    // Indexing progress of a huge file, or the save state of the document
+    void DrawStatus();
+    // Rolling timings of the profiled scopes, while profiling is on
+    void DrawProfile();
 
     void NormalMode();
 
@@ -103,6 +117,10 @@ private:
     Color currentColor = BLACK;
     Color currentBackgroundColor = Color{0, 0, 0, 0};
 
+    // Offers the untitled documents a crashed session left, one at a time
+    void DrawRecoverPage(float initX, float initY);
+    std::vector< std::string > mOrphans{};
+
 private:
     bool closed = false;
     Keybind mKeybind{};
@@ -112,6 +130,12 @@ private:
 
     FontFactory* fonts{new FontFactory};
     DocumentFont* mDocumentFont{new DocumentFont};
+    layout::FontMetrics mMetrics{mDocumentFont};
+
+    // rendered lines of the document
+    TileCache mTiles{};
+
+    bool mShowProfile{false};
 
     EditorMode mMode{EditorMode::Insert};
     EditorPage mPage{EditorPage::None};
@@ -0,0 +1,149 @@
+#include "history/backend.hpp"
+
+#include <algorithm>
+
+namespace history {
+
+    namespace {
+        using Node = rope::Node;
+
+        bool is_concatenation(const Node* node) {
+            return node->children().size() == 2;
+        }
+
+        // Length of the subtrees `a` and `b` share at their start, or at
+        // their end. Stops at the first pair of nodes that differ.
+        std::size_t shared_length(const Rope& a, const Rope& b, bool fromEnd) {
+            std::vector< const Node* > left{a.root().get()};
+            std::vector< const Node* > right{b.root().get()};
+            std::size_t shared = 0;
+
+            auto expand = [&](std::vector< const Node* >& stack) {
+                auto children = stack.back()->children();
+                stack.pop_back();
+                if (fromEnd) std::swap(children[0], children[1]);
+                stack.push_back(children[1].get());
+                stack.push_back(children[0].get());
+            };
+
+            while (!left.empty() && !right.empty()) {
+                const Node* x = left.back();
+                const Node* y = right.back();
+                if (x == y) {
+                    shared += x->length();
+                    left.pop_back();
+                    right.pop_back();
+                    continue;
+                }
+
+                // only the longer node can contain the other one
+                bool splitX = x->length() >= y->length() && is_concatenation(x);
+                bool splitY = y->length() >= x->length() && is_concatenation(y);
+                if (!splitX && !splitY) break;
+                if (splitX) expand(left);
+                if (splitY) expand(right);
+            }
+            return shared;
+        }
+
+        bool same(const nchar& a, const nchar& b) {
+            return a.codepoint() == b.codepoint() && a.sameStyle(b);
+        }
+    }  // namespace
+
+    Rope apply(const Rope& rope, const Edit& edit) {
+        if (!edit.others.empty()) {
+            std::vector< Rope::Splice > splices{
+                {edit.position, edit.removed.length(), edit.inserted}};
+            for (const auto& other : edit.others) {
+                splices.push_back(
+                    {other.position, other.removed.length(), other.inserted});
+            }
+            return rope.splice(splices);
+        }
+
+        if (edit.removed.length() == 0) {
+            return rope.insert(edit.position, edit.inserted);
+        }
+        if (edit.inserted.length() == 0) {
+            return rope.erase(edit.position, edit.removed.length());
+        }
+        return rope.replace(edit.position, edit.removed.length(),
+                            edit.inserted);
+    }
+
+    Rope revert(const Rope& rope, const Edit& edit) {
+        Edit inverse{edit.kind, edit.position, edit.inserted, edit.removed};
+
+        // the ranges after the first have moved by the ones before them
+        std::ptrdiff_t shift = edit.inserted.length();
+        shift -= edit.removed.length();
+        for (const auto& other : edit.others) {
+            inverse.others.push_back(
+                {other.position + shift, other.inserted, other.removed});
+            shift += other.inserted.length();
+            shift -= other.removed.length();
+        }
+        return apply(rope, inverse);
+    }
+
+    Edit combine(const Rope& rope,
+                 const std::vector< Rope::Splice >& splices) {
+        if (splices.empty()) return Edit{};
+
+        // splitting copies the leaves at both ends, a short range is
+        // cheaper copied on its own
+        auto removed = [&](const Rope::Splice& splice) {
+            if (splice.length >= Rope::leafSize) {
+                return rope.subrope(splice.start, splice.length);
+            }
+            return Rope(rope.subnstr(splice.start, splice.length));
+        };
+
+        const Rope::Splice& first = splices.front();
+        Edit edit{EditKind::Other, first.start, removed(first), first.text};
+        for (std::size_t i = 1; i < splices.size(); ++i) {
+            const Rope::Splice& splice = splices[i];
+            edit.others.push_back(
+                {splice.start, removed(splice), splice.text});
+        }
+        return edit;
+    }
+
+    Edit diff(const Rope& before, const Rope& after) {
+        std::size_t limit = std::min(before.length(), after.length());
+
+        // compare leaf sized blocks where the shared nodes end
+        std::size_t prefix = std::min(shared_length(before, after, false),
+                                      limit);
+        while (prefix < limit) {
+            std::size_t size = std::min(Rope::leafSize, limit - prefix);
+            nstring a = before.subnstr(prefix, size);
+            nstring b = after.subnstr(prefix, size);
+
+            std::size_t i = 0;
+            while (i < size && same(a[i], b[i])) ++i;
+            prefix += i;
+            if (i < size) break;
+        }
+
+        limit -= prefix;
+        std::size_t suffix = std::min(shared_length(before, after, true),
+                                      limit);
+        while (suffix < limit) {
+            std::size_t size = std::min(Rope::leafSize, limit - suffix);
+            nstring a = before.subnstr(before.length() - suffix - size, size);
+            nstring b = after.subnstr(after.length() - suffix - size, size);
+
+            std::size_t i = 0;
+            while (i < size && same(a[size - 1 - i], b[size - 1 - i])) ++i;
+            suffix += i;
+            if (i < size) break;
+        }
+
+        return Edit{EditKind::Other, prefix,
+                    before.subrope(prefix, before.length() - prefix - suffix),
+                    after.subrope(prefix, after.length() - prefix - suffix)};
+    }
+
+}  // namespace history
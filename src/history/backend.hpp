@@ -0,0 +1,82 @@
+#ifndef HISTORY_BACKEND_HPP
+#define HISTORY_BACKEND_HPP
+
+#include <vector>
+
+#include "cursor.hpp"
+#include "rope/rope.hpp"
+
+namespace history {
+    enum class EditKind { Typing, Erase, Style, Other };
+
+    // One range of the document replaced by an edit
+    struct Change {
+        std::size_t position{};
+        Rope removed{};
+        Rope inserted{};
+    };
+
+    // One change of the document: `removed` is replaced by `inserted` at
+    // `position`. Inserts have nothing removed, erases insert nothing and
+    // style changes replace a range with the same text restyled. The texts
+    // are ropes, so a large paste or erase shares its nodes with the
+    // document instead of copying them.
+    // An edit at several places at once (multiple cursors) lists the ranges
+    // after the first in `others`, sorted and not overlapping, with their
+    // positions in the text before the edit like `position`.
+    struct Edit {
+        EditKind kind{EditKind::Other};
+        std::size_t position{};
+        Rope removed{};
+        Rope inserted{};
+        std::vector< Change > others{};
+    };
+
+    Rope apply(const Rope& rope, const Edit& edit);
+    Rope revert(const Rope& rope, const Edit& edit);
+
+    // One edit with a range per splice, see Rope::splice(), so a change at
+    // many places undoes and journals as a single edit whose size is that
+    // of the text it changed.
+    Edit combine(const Rope& rope, const std::vector< Rope::Splice >& splices);
+
+    // The edit turning `before` into `after`: the range between their common
+    // prefix and suffix. Subtrees both share are skipped without reading
+    // them, so two versions of one document diff in about the time it takes
+    // to compare the leaves that changed.
+    Edit diff(const Rope& before, const Rope& after);
+}  // namespace history
+
+/**
+ * @brief Storage strategy for the undo/redo history of a Document.
+ * @details The document reports every edit together with the state it is
+ * applied to, and asks the backend to step back and forth through them.
+ */
+class UndoBackend {
+public:
+    virtual ~UndoBackend() = default;
+
+    /**
+     * @brief Remember an edit before it is applied.
+     * @param before The rope the edit is applied to.
+     * @param cursor The cursor before the edit.
+     * @param edit The edit, typing and erase runs may be coalesced.
+     */
+    virtual void record(const Rope& before, const Cursor& cursor,
+                        const history::Edit& edit) = 0;
+
+    // End the current typing run, the next edit starts a new entry.
+    virtual void seal() = 0;
+
+    // Move the given state one step back/forward, if possible.
+    virtual bool undo(Rope& rope, Cursor& cursor) = 0;
+    virtual bool redo(Rope& rope, Cursor& cursor) = 0;
+
+    virtual void clear() = 0;
+
+    virtual std::size_t retained_bytes() const = 0;
+    virtual std::size_t undo_count() const = 0;
+    virtual std::size_t redo_count() const = 0;
+};
+
+#endif  // HISTORY_BACKEND_HPP
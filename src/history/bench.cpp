@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "history/operation_log.hpp"
+#include "history/snapshot_history.hpp"
+
+using history::Edit;
+using history::EditKind;
+using Clock = std::chrono::steady_clock;
+
+// Replays the same pseudo-random editing session (typing runs, backspacing,
+// cursor jumps and formatting) into both undo backends, then compares the
+// memory they retain and how long undo takes.
+
+std::size_t editCount = 100000;
+constexpr std::size_t undoCount = 1000;
+
+struct Result {
+    Rope rope;
+    double recordSeconds;
+    double undoAverageUs;
+    double undoMaxUs;
+    std::size_t bytes;
+    std::size_t entries;
+};
+
+Result run(UndoBackend& backend) {
+    std::mt19937 rng(2024);
+    Rope rope(std::string(20000, 'x') + "\n");
+    Cursor cursor{};
+    std::size_t pos = 0;
+
+    auto edit = [&](const Edit& edit) {
+        backend.record(rope, cursor, edit);
+        rope = history::apply(rope, edit);
+        if (!rope.is_balanced()) rope = rope.rebalance();
+    };
+
+    Clock::time_point start = Clock::now();
+
+    for (std::size_t i = 0; i < editCount; ++i) {
+        int dice = rng() % 100;
+
+        if (dice < 2) {
+            // jump elsewhere
+            pos = rng() % rope.length();
+            backend.seal();
+        } else if (dice < 80) {
+            char c = "etaoin shrdlu"[rng() % 13];
+            nstring typed(std::string(1, c));
+            edit({EditKind::Typing, pos, nstring(), typed});
+            ++pos;
+            if (c == ' ') backend.seal();
+        } else if (dice < 95) {
+            if (pos == 0) continue;
+            edit({EditKind::Erase, pos - 1, rope.subnstr(pos - 1, 1),
+                  nstring()});
+            --pos;
+        } else {
+            std::size_t length =
+                std::min< std::size_t >(20, rope.length() - 1 - pos);
+            nstring styled = rope.subnstr(pos, length);
+            styled.toggleBold(0, styled.length());
+            edit({EditKind::Style, pos, rope.subnstr(pos, length), styled});
+        }
+    }
+
+    Result result{};
+    result.recordSeconds =
+        std::chrono::duration< double >(Clock::now() - start).count();
+    result.bytes = backend.retained_bytes();
+    result.entries = backend.undo_count();
+    result.rope = rope;
+
+    double total = 0;
+    for (std::size_t i = 0; i < undoCount; ++i) {
+        Clock::time_point before = Clock::now();
+        if (!backend.undo(rope, cursor)) break;
+        double us = std::chrono::duration< double, std::micro >(Clock::now() -
+                                                                before)
+                        .count();
+        total += us;
+        result.undoMaxUs = std::max(result.undoMaxUs, us);
+    }
+    result.undoAverageUs = total / undoCount;
+
+    return result;
+}
+
+void print(const std::string& name, const Result& result) {
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(10) << result.entries << std::setw(12)
+              << std::fixed << std::setprecision(2)
+              << result.bytes / 1048576.0 << std::setw(12)
+              << result.recordSeconds << std::setw(12)
+              << result.undoAverageUs << std::setw(12) << result.undoMaxUs
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) editCount = std::stoul(argv[1]);
+
+    SnapshotHistory snapshots;
+    snapshots.set_budget(static_cast< std::size_t >(-1));
+
+    OperationLog log;
+    log.set_max_entries(static_cast< std::size_t >(-1));
+
+    std::cout << editCount << " edits, " << undoCount << " undos"
+              << std::endl;
+    std::cout << std::left << std::setw(12) << "backend" << std::right
+              << std::setw(10) << "entries" << std::setw(12) << "MiB"
+              << std::setw(12) << "record s" << std::setw(12) << "undo avg us"
+              << std::setw(12) << "undo max us" << std::endl;
+
+    Result snapshotResult = run(snapshots);
+    print("snapshot", snapshotResult);
+
+    Result logResult = run(log);
+    print("oplog", logResult);
+
+    std::cout << "Same text:  " << (snapshotResult.rope == logResult.rope)
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+#include "history/operation_log.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "history/serialize.hpp"
+
+using history::Edit;
+using history::EditKind;
+using history::read_others;
+using history::read_text;
+using history::read_value;
+using history::write_others;
+using history::write_text;
+using history::write_value;
+
+namespace {
+    constexpr char magic[4] = {'O', 'P', 'L', 'G'};
+    constexpr std::uint32_t version = 3;
+
+    void write_entry(std::ostream& out, const OperationLog::Entry& entry) {
+        write_value(out, static_cast< std::uint8_t >(entry.edit.kind));
+        write_value(out, static_cast< std::uint64_t >(entry.edit.position));
+        write_value(out, static_cast< std::int32_t >(entry.cursor.line));
+        write_value(out, static_cast< std::int32_t >(entry.cursor.column));
+        write_text(out, entry.edit.removed);
+        write_text(out, entry.edit.inserted);
+        write_others(out, entry.edit);
+    }
+
+    bool read_entry(std::istream& in, OperationLog::Entry& entry) {
+        std::uint8_t kind{};
+        std::uint64_t position{};
+        std::int32_t line{}, column{};
+
+        if (!read_value(in, kind) || !read_value(in, position) ||
+            !read_value(in, line) || !read_value(in, column)) {
+            return false;
+        }
+        if (kind > static_cast< std::uint8_t >(EditKind::Other)) return false;
+
+        entry.edit.kind = static_cast< EditKind >(kind);
+        entry.edit.position = position;
+        entry.cursor = Cursor{line, column};
+
+        return read_text(in, entry.edit.removed) &&
+               read_text(in, entry.edit.inserted) &&
+               read_others(in, entry.edit);
+    }
+
+    // Keystroke runs stay one leaf instead of a chain of one-character ones
+    Rope join(const Rope& left, const Rope& right) {
+        if (left.length() + right.length() > Rope::leafSize) {
+            return left.append(right);
+        }
+        return Rope(left.to_nstring() + right.to_nstring());
+    }
+
+    bool read_entries(std::istream& in,
+                      std::vector< OperationLog::Entry >& entries) {
+        std::uint64_t count{};
+        if (!read_value(in, count)) return false;
+
+        for (std::uint64_t i = 0; i < count; ++i) {
+            OperationLog::Entry entry{};
+            if (!read_entry(in, entry)) return false;
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    }
+}  // namespace
+
+void OperationLog::record(const Rope& before, const Cursor& cursor,
+                          const Edit& edit) {
+    Clock::time_point now = Clock::now();
+
+    bool coalescable =
+        edit.kind == EditKind::Typing || edit.kind == EditKind::Erase;
+    bool continuesRun = mRunOpen && coalescable && !mUndo.empty() &&
+                        mRunLength < maxRunLength &&
+                        now - mLastRecord < runTimeout;
+
+    mLastRecord = now;
+    clear_redo();
+
+    if (continuesRun && coalesce(edit)) {
+        ++mRunLength;
+        return;
+    }
+
+    mRunOpen = coalescable;
+    mRunLength = 1;
+
+    push_undo({edit, cursor}, before);
+    trim();
+}
+
+void OperationLog::seal() { mRunOpen = false; }
+
+bool OperationLog::undo(Rope& rope, Cursor& cursor) {
+    if (mUndo.empty()) return false;
+    seal();
+
+    Entry entry = std::move(mUndo.back());
+    mUndo.pop_back();
+
+    rope = history::revert(rope, entry.edit);
+    std::swap(cursor, entry.cursor);
+
+    mRedo.push_back(std::move(entry));
+    return true;
+}
+
+bool OperationLog::redo(Rope& rope, Cursor& cursor) {
+    if (mRedo.empty()) return false;
+    seal();
+
+    Entry entry = std::move(mRedo.back());
+    mRedo.pop_back();
+
+    // the checkpoint of this entry, if it had one, is still kept
+    rope = history::apply(rope, entry.edit);
+    std::swap(cursor, entry.cursor);
+
+    mUndo.push_back(std::move(entry));
+    return true;
+}
+
+void OperationLog::clear() {
+    mUndo.clear();
+    mRedo.clear();
+    for (const auto& checkpoint : mCheckpoints) {
+        mRetained.remove(checkpoint.rope);
+    }
+    mCheckpoints.clear();
+
+    mFirstEntry = 0;
+    mEntryBytes = 0;
+    seal();
+}
+
+void OperationLog::set_max_entries(std::size_t entries) {
+    mMaxEntries = entries;
+    trim();
+}
+
+std::size_t OperationLog::max_entries() const { return mMaxEntries; }
+
+std::size_t OperationLog::retained_bytes() const {
+    return mEntryBytes + mRetained.bytes();
+}
+
+std::size_t OperationLog::undo_count() const { return mUndo.size(); }
+
+std::size_t OperationLog::redo_count() const { return mRedo.size(); }
+
+std::size_t OperationLog::checkpoint_count() const {
+    return mCheckpoints.size();
+}
+
+bool OperationLog::save(std::ostream& out) const {
+    out.write(magic, sizeof(magic));
+    write_value(out, version);
+
+    // without a checkpoint nothing was ever recorded
+    bool hasBase = !mCheckpoints.empty();
+    write_value(out, static_cast< std::uint8_t >(hasBase));
+    if (hasBase) write_text(out, mCheckpoints.front().rope);
+
+    write_value(out, static_cast< std::uint64_t >(mUndo.size()));
+    for (const auto& entry : mUndo) write_entry(out, entry);
+
+    write_value(out, static_cast< std::uint64_t >(mRedo.size()));
+    for (const auto& entry : mRedo) write_entry(out, entry);
+
+    return !!out;
+}
+
+bool OperationLog::load(std::istream& in, Rope& rope) {
+    char header[sizeof(magic)]{};
+    std::uint32_t fileVersion{};
+    std::uint8_t hasBase{};
+
+    if (!in.read(header, sizeof(header)) ||
+        !std::equal(header, header + sizeof(header), magic) ||
+        !read_value(in, fileVersion) || fileVersion != version ||
+        !read_value(in, hasBase)) {
+        return false;
+    }
+
+    Rope base;
+    if (hasBase && !read_text(in, base)) return false;
+
+    std::vector< Entry > undo, redo;
+    if (!read_entries(in, undo) || !read_entries(in, redo)) return false;
+    if (!hasBase && !(undo.empty() && redo.empty())) return false;
+
+    clear();
+    if (!hasBase) return true;
+
+    // replaying rebuilds the checkpoints on the way
+    Rope current = base;
+    for (auto& entry : undo) {
+        if (!current.is_balanced()) current = current.rebalance();
+        push_undo(std::move(entry), current);
+        current = history::apply(current, mUndo.back().edit);
+    }
+
+    mRedo = std::move(redo);
+    for (const auto& entry : mRedo) mEntryBytes += entry_bytes(entry);
+
+    rope = current;
+    return true;
+}
+
+bool OperationLog::coalesce(const Edit& edit) {
+    Edit& last = mUndo.back().edit;
+    if (last.kind != edit.kind) return false;
+
+    std::size_t before = entry_bytes(mUndo.back());
+
+    if (edit.kind == EditKind::Typing) {
+        bool adjacent = last.removed.length() == 0 &&
+                        edit.removed.length() == 0 &&
+                        edit.position == last.position + last.inserted.length();
+        if (!adjacent) return false;
+
+        last.inserted = join(last.inserted, edit.inserted);
+    } else {
+        if (last.inserted.length() != 0 || edit.inserted.length() != 0) {
+            return false;
+        }
+
+        if (edit.position + edit.removed.length() == last.position) {
+            // backspace
+            last.removed = join(edit.removed, last.removed);
+            last.position = edit.position;
+        } else if (edit.position == last.position) {
+            // delete
+            last.removed = join(last.removed, edit.removed);
+        } else {
+            return false;
+        }
+    }
+
+    mEntryBytes = mEntryBytes - before + entry_bytes(mUndo.back());
+    return true;
+}
+
+void OperationLog::push_undo(Entry entry, const Rope& before) {
+    std::size_t index = mFirstEntry + mUndo.size();
+
+    // after undoing back to a checkpoint it is already the state `before`
+    bool hasCheckpoint =
+        !mCheckpoints.empty() && mCheckpoints.back().entry == index;
+    if (index % checkpointInterval == 0 && !hasCheckpoint) {
+        mRetained.add(before);
+        mCheckpoints.push_back({index, before});
+    }
+
+    mEntryBytes += entry_bytes(entry);
+    mUndo.push_back(std::move(entry));
+}
+
+void OperationLog::clear_redo() {
+    for (const auto& entry : mRedo) mEntryBytes -= entry_bytes(entry);
+    mRedo.clear();
+
+    // checkpoints past the current entry belonged to the discarded branch
+    std::size_t end = mFirstEntry + mUndo.size();
+    while (!mCheckpoints.empty() && mCheckpoints.back().entry > end) {
+        mRetained.remove(mCheckpoints.back().rope);
+        mCheckpoints.pop_back();
+    }
+}
+
+void OperationLog::trim() {
+    // drop whole checkpoint intervals, keeping at least one entry
+    while (mUndo.size() > mMaxEntries && mCheckpoints.size() > 1 &&
+           mCheckpoints[1].entry < mFirstEntry + mUndo.size()) {
+        while (mFirstEntry < mCheckpoints[1].entry) {
+            mEntryBytes -= entry_bytes(mUndo.front());
+            mUndo.pop_front();
+            ++mFirstEntry;
+        }
+
+        mRetained.remove(mCheckpoints.front().rope);
+        mCheckpoints.pop_front();
+    }
+}
+
+std::size_t OperationLog::entry_bytes(const Entry& entry) {
+    std::size_t length =
+        entry.edit.removed.length() + entry.edit.inserted.length();
+    for (const auto& other : entry.edit.others) {
+        length += other.removed.length() + other.inserted.length();
+    }
+    return sizeof(Entry) + entry.edit.others.size() * sizeof(history::Change) +
+           length * sizeof(nchar);
+}
@@ -0,0 +1,102 @@
+#ifndef HISTORY_OPERATION_LOG_HPP
+#define HISTORY_OPERATION_LOG_HPP
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#include "history/backend.hpp"
+#include "history/retained_nodes.hpp"
+
+/**
+ * @brief Undo/redo history made of the edits themselves.
+ * @details An entry only keeps the text its edit removed and inserted, so a
+ * keystroke costs one nchar instead of the nodes it re-created; undo applies
+ * the inverse edit to the current rope. Typing and erase runs are coalesced
+ * like in SnapshotHistory.
+ *
+ * Every checkpointInterval entries the rope the next entry applies to is kept
+ * as a checkpoint. Once the log grows past its entry limit, everything before
+ * the second checkpoint is dropped, so the oldest kept checkpoint is always
+ * the base the remaining entries replay from. save() writes that base and
+ * the entries, load() replays them to rebuild the history after a restart.
+ */
+class OperationLog : public UndoBackend {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t checkpointInterval = 1024;
+    static constexpr std::size_t defaultMaxEntries = 64 * checkpointInterval;
+    static constexpr std::size_t maxRunLength = 64;
+    static constexpr Clock::duration runTimeout = std::chrono::seconds(1);
+
+    struct Entry {
+        history::Edit edit;
+        // the cursor to restore: before the edit for undo entries, after it
+        // for redo entries
+        Cursor cursor;
+    };
+
+    struct Checkpoint {
+        // absolute index of the entry that applies to this rope
+        std::size_t entry;
+        Rope rope;
+    };
+
+    void record(const Rope& before, const Cursor& cursor,
+                const history::Edit& edit) override;
+
+    void seal() override;
+
+    bool undo(Rope& rope, Cursor& cursor) override;
+    bool redo(Rope& rope, Cursor& cursor) override;
+
+    void clear() override;
+
+    void set_max_entries(std::size_t entries);
+    std::size_t max_entries() const;
+
+    std::size_t retained_bytes() const override;
+    std::size_t undo_count() const override;
+    std::size_t redo_count() const override;
+    std::size_t checkpoint_count() const;
+
+    /**
+     * @brief Write the oldest checkpoint and every entry to a stream.
+     * @return false if the stream failed.
+     */
+    bool save(std::ostream& out) const;
+
+    /**
+     * @brief Replace the history with one written by save().
+     * @param rope Receives the document the log replays to. The caller should
+     * check it against the document it belongs to before trusting the log.
+     * @return false if the stream is not a complete log.
+     */
+    bool load(std::istream& in, Rope& rope);
+
+private:
+    bool coalesce(const history::Edit& edit);
+    void push_undo(Entry entry, const Rope& before);
+    void clear_redo();
+    void trim();
+
+    static std::size_t entry_bytes(const Entry& entry);
+
+    std::deque< Entry > mUndo{};
+    std::vector< Entry > mRedo{};
+
+    // absolute index of mUndo.front()
+    std::size_t mFirstEntry{0};
+    std::deque< Checkpoint > mCheckpoints{};
+    history::RetainedNodes mRetained{};
+    std::size_t mEntryBytes{0};
+    std::size_t mMaxEntries{defaultMaxEntries};
+
+    bool mRunOpen{false};
+    std::size_t mRunLength{0};
+    Clock::time_point mLastRecord{};
+};
+
+#endif  // HISTORY_OPERATION_LOG_HPP
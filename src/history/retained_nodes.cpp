@@ -0,0 +1,76 @@
+#include "history/retained_nodes.hpp"
+
+namespace history {
+
+    std::size_t RetainedNodes::add(const Rope& rope) {
+        return acquire(rope.root(), &Refs::added);
+    }
+
+    void RetainedNodes::remove(const Rope& rope) {
+        release(rope.root().get(), &Refs::added);
+    }
+
+    void RetainedNodes::set_live(const Rope& rope) {
+        // acquired first so the nodes both versions share are never released
+        acquire(rope.root(), &Refs::live);
+        if (mHasLive) release(mLive.root().get(), &Refs::live);
+
+        mLive = rope;
+        mHasLive = true;
+    }
+
+    std::size_t RetainedNodes::bytes() const { return mBytes; }
+
+    std::size_t RetainedNodes::node_count() const { return mRefs.size(); }
+
+    std::size_t RetainedNodes::acquire(const rope::Node::Ptr& node,
+                                       Count count) {
+        if (!node) return 0;
+
+        Refs& refs = mRefs[node.get()];
+        bool wasCharged = charged(refs);
+        if ((refs.*count)++ > 0) return 0;
+
+        std::size_t added = recharge(node.get(), wasCharged, refs);
+        for (const auto& child : node->children()) {
+            added += acquire(child, count);
+        }
+        return added;
+    }
+
+    void RetainedNodes::release(const rope::Node* node, Count count) {
+        if (!node) return;
+
+        auto it = mRefs.find(node);
+        if (it == mRefs.end() || it->second.*count == 0) return;
+
+        Refs& refs = it->second;
+        bool wasCharged = charged(refs);
+        if (--(refs.*count) > 0) return;
+
+        recharge(node, wasCharged, refs);
+        if (refs.added == 0 && refs.live == 0) mRefs.erase(it);
+
+        // the node is still alive here, the rope being removed owns it
+        for (const auto& child : node->children()) {
+            release(child.get(), count);
+        }
+    }
+
+    std::size_t RetainedNodes::recharge(const rope::Node* node,
+                                        bool wasCharged, const Refs& refs) {
+        if (charged(refs) == wasCharged) return 0;
+
+        if (wasCharged) {
+            mBytes -= node->bytes();
+            return 0;
+        }
+        mBytes += node->bytes();
+        return node->bytes();
+    }
+
+    bool RetainedNodes::charged(const Refs& refs) {
+        return refs.added > 0 && refs.live == 0;
+    }
+
+}  // namespace history
@@ -0,0 +1,60 @@
+#ifndef HISTORY_RETAINED_NODES_HPP
+#define HISTORY_RETAINED_NODES_HPP
+
+#include <unordered_map>
+
+#include "rope/rope.hpp"
+
+namespace history {
+
+    /**
+     * @brief Memory accounting for a set of ropes that share nodes.
+     * @details Keeps a reference count for every node reachable from the
+     * added ropes, counting one reference per parent inside the set plus one
+     * per rope root. Adding a rope only walks the nodes that are not in the
+     * set yet, so the cost of an edit is proportional to the nodes it
+     * created, and removing a rope only releases the nodes no other rope in
+     * the set still reaches.
+     *
+     * The live rope, the one being edited, is counted the same way but apart:
+     * nodes it reaches are not charged, since they would be held without the
+     * set, so bytes() is what the added ropes retain on their own.
+     */
+    class RetainedNodes {
+    public:
+        // Returns the bytes of the nodes that were not retained before.
+        std::size_t add(const Rope& rope);
+        void remove(const Rope& rope);
+
+        // Replaces the rope whose nodes are not charged.
+        void set_live(const Rope& rope);
+
+        std::size_t bytes() const;
+        std::size_t node_count() const;
+
+    private:
+        // references from the added ropes and from the live one
+        struct Refs {
+            std::size_t added{0};
+            std::size_t live{0};
+        };
+        using Count = std::size_t Refs::*;
+
+        std::size_t acquire(const rope::Node::Ptr& node, Count count);
+        void release(const rope::Node* node, Count count);
+
+        // Updates the bytes after a count of the node changed, returns the
+        // bytes it newly charged
+        std::size_t recharge(const rope::Node* node, bool wasCharged,
+                             const Refs& refs);
+        static bool charged(const Refs& refs);
+
+        std::unordered_map< const rope::Node*, Refs > mRefs{};
+        std::size_t mBytes{0};
+        Rope mLive{};
+        bool mHasLive{false};
+    };
+
+}  // namespace history
+
+#endif  // HISTORY_RETAINED_NODES_HPP
@@ -0,0 +1,173 @@
+#include "history/serialize.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "rope/builder.hpp"
+#include "text/style_table.hpp"
+#include "text/utf8.hpp"
+
+namespace history {
+
+    namespace {
+        struct Run {
+            std::uint32_t length{};
+            std::uint32_t style{};
+        };
+
+        // Read in blocks, a corrupt size fails at the end of the input
+        // instead of allocating it
+        bool read_bytes(std::istream& in, std::uint64_t size,
+                        std::string& bytes) {
+            constexpr std::uint64_t block = 1 << 16;
+            bytes.clear();
+            while (bytes.size() < size) {
+                std::size_t offset = bytes.size();
+                std::size_t count = std::min(block, size - offset);
+                bytes.resize(offset + count);
+                if (!in.read(bytes.data() + offset, count)) return false;
+            }
+            return true;
+        }
+    }  // namespace
+
+    void write_text(std::ostream& out, const Rope& text) {
+        std::string bytes;
+        bytes.reserve(text.length());
+        std::vector< Run > runs;
+        StyleTable styles;
+
+        text.for_each_chunk([&](const nstring& chunk) {
+            const nchar* previous = nullptr;
+            for (std::size_t i = 0; i < chunk.length(); ++i) {
+                const nchar& c = chunk[i];
+                utf8::append(bytes, c.codepoint());
+
+                if (previous && previous->sameStyle(c)) {
+                    ++runs.back().length;
+                } else if (std::uint32_t style = styles.add(c);
+                           !previous && !runs.empty() &&
+                           runs.back().style == style) {
+                    // the run goes on in the next chunk
+                    ++runs.back().length;
+                } else {
+                    runs.push_back({1, style});
+                }
+                previous = &c;
+            }
+        });
+
+        std::string table;
+        styles.write(table);
+
+        write_value(out, static_cast< std::uint64_t >(text.length()));
+        write_value(out, static_cast< std::uint64_t >(bytes.size()));
+        out.write(bytes.data(), bytes.size());
+        write_value(out, static_cast< std::uint64_t >(table.size()));
+        out.write(table.data(), table.size());
+        write_value(out, static_cast< std::uint64_t >(runs.size()));
+        out.write(reinterpret_cast< const char* >(runs.data()),
+                  runs.size() * sizeof(Run));
+    }
+
+    bool read_text(std::istream& in, Rope& text) {
+        std::uint64_t length{}, size{}, tableSize{}, runCount{};
+        std::string bytes, table;
+        std::vector< nchar > styles;
+
+        if (!read_value(in, length) || !read_value(in, size) ||
+            !read_bytes(in, size, bytes) || !read_value(in, tableSize) ||
+            !read_bytes(in, tableSize, table) ||
+            StyleTable::read(table.data(), table.size(), styles) !=
+                tableSize ||
+            !read_value(in, runCount) || runCount > length) {
+            return false;
+        }
+
+        std::vector< Run > runs(runCount);
+        std::uint64_t styled = 0;
+        for (auto& run : runs) {
+            if (!read_value(in, run.length) || !read_value(in, run.style) ||
+                run.style >= styles.size()) {
+                return false;
+            }
+            styled += run.length;
+        }
+        if (styled != length) return false;
+
+        // every character gets the style of the run it is in
+        rope::Builder builder;
+        std::size_t run = 0, left = runs.empty() ? 0 : runs[0].length;
+        bool overrun = false;
+        auto push = [&](int codepoint) {
+            while (left == 0 && ++run < runs.size()) left = runs[run].length;
+            if (left == 0) {
+                overrun = true;
+                return;
+            }
+            builder.append(nchar(codepoint, styles[runs[run].style]));
+            --left;
+        };
+
+        // exact codepoints, without the line ending normalization of text
+        // files
+        utf8::Decoder decoder;
+        decoder.feed(bytes.data(), bytes.size(), push);
+        decoder.finish(push);
+        if (overrun || builder.length() != length) return false;
+
+        text = builder.build();
+        return true;
+    }
+
+    void write_edit(std::ostream& out, const Edit& edit) {
+        write_value(out, static_cast< std::uint8_t >(edit.kind));
+        write_value(out, static_cast< std::uint64_t >(edit.position));
+        write_text(out, edit.removed);
+        write_text(out, edit.inserted);
+        write_others(out, edit);
+    }
+
+    bool read_edit(std::istream& in, Edit& edit) {
+        std::uint8_t kind{};
+        std::uint64_t position{};
+
+        if (!read_value(in, kind) || !read_value(in, position)) return false;
+        if (kind > static_cast< std::uint8_t >(EditKind::Other)) return false;
+
+        edit.kind = static_cast< EditKind >(kind);
+        edit.position = position;
+
+        return read_text(in, edit.removed) && read_text(in, edit.inserted) &&
+               read_others(in, edit);
+    }
+
+    void write_others(std::ostream& out, const Edit& edit) {
+        write_value(out, static_cast< std::uint64_t >(edit.others.size()));
+        for (const auto& other : edit.others) {
+            write_value(out, static_cast< std::uint64_t >(other.position));
+            write_text(out, other.removed);
+            write_text(out, other.inserted);
+        }
+    }
+
+    bool read_others(std::istream& in, Edit& edit) {
+        std::uint64_t count{};
+        if (!read_value(in, count)) return false;
+
+        edit.others.clear();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            Change other{};
+            std::uint64_t position{};
+            if (!read_value(in, position) || !read_text(in, other.removed) ||
+                !read_text(in, other.inserted)) {
+                return false;
+            }
+            other.position = position;
+            edit.others.push_back(std::move(other));
+        }
+        return true;
+    }
+
+}  // namespace history
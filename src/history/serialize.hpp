@@ -0,0 +1,34 @@
+#ifndef HISTORY_SERIALIZE_HPP
+#define HISTORY_SERIALIZE_HPP
+
+#include <iostream>
+
+#include "history/backend.hpp"
+
+// Binary encoding of edits, shared by the files that store them. Integers
+// are written in native byte order. Text is written as UTF-8 and runs of
+// styles with a StyleTable, so it takes about a byte per character.
+namespace history {
+    template < typename T >
+    void write_value(std::ostream& out, T value) {
+        out.write(reinterpret_cast< const char* >(&value), sizeof(value));
+    }
+
+    template < typename T >
+    bool read_value(std::istream& in, T& value) {
+        return !!in.read(reinterpret_cast< char* >(&value), sizeof(value));
+    }
+
+    // Written chunk by chunk, read back into balanced leaves
+    void write_text(std::ostream& out, const Rope& text);
+    bool read_text(std::istream& in, Rope& text);
+
+    void write_edit(std::ostream& out, const Edit& edit);
+    bool read_edit(std::istream& in, Edit& edit);
+
+    // The ranges of a multi-range edit after the first, see Edit::others
+    void write_others(std::ostream& out, const Edit& edit);
+    bool read_others(std::istream& in, Edit& edit);
+}  // namespace history
+
+#endif  // HISTORY_SERIALIZE_HPP
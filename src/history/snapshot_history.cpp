@@ -0,0 +1,118 @@
+#include "history/snapshot_history.hpp"
+
+using history::EditKind;
+
+void SnapshotHistory::record(const Rope& before, const Cursor& cursor,
+                             const history::Edit& edit) {
+    EditKind kind = edit.kind;
+    Clock::time_point now = Clock::now();
+
+    // the document holds `before` anyway, entries are charged for the rest
+    mRetained.set_live(before);
+
+    bool coalescable = kind == EditKind::Typing || kind == EditKind::Erase;
+    bool continuesRun = mRunOpen && coalescable && !mUndo.empty() &&
+                        mUndo.back().kind == kind &&
+                        mRunLength < maxRunLength &&
+                        now - mLastRecord < runTimeout;
+
+    mLastRecord = now;
+
+    if (continuesRun) {
+        // the entry of the run already holds the state before its first edit
+        ++mRunLength;
+        clear_redo();
+        return;
+    }
+
+    mRunOpen = coalescable;
+    mRunLength = 1;
+
+    // callers may save the same state twice, e.g. before a formatting call
+    // that saves on its own
+    if (!mUndo.empty() && mUndo.back().rope.root() == before.root()) {
+        clear_redo();
+        return;
+    }
+
+    push_undo({before, cursor, kind});
+    clear_redo();
+    enforce_budget();
+}
+
+void SnapshotHistory::seal() { mRunOpen = false; }
+
+bool SnapshotHistory::undo(Rope& rope, Cursor& cursor) {
+    if (mUndo.empty()) return false;
+    seal();
+
+    Entry current{rope, cursor, mUndo.back().kind};
+    current.bytes = mRetained.add(current.rope);
+    mRedo.push_back(std::move(current));
+
+    rope = mUndo.back().rope;
+    cursor = mUndo.back().cursor;
+    mRetained.set_live(rope);
+
+    mRetained.remove(mUndo.back().rope);
+    mUndo.pop_back();
+    return true;
+}
+
+bool SnapshotHistory::redo(Rope& rope, Cursor& cursor) {
+    if (mRedo.empty()) return false;
+    seal();
+
+    push_undo({rope, cursor, mRedo.back().kind});
+
+    rope = mRedo.back().rope;
+    cursor = mRedo.back().cursor;
+    mRetained.set_live(rope);
+
+    mRetained.remove(mRedo.back().rope);
+    mRedo.pop_back();
+    return true;
+}
+
+void SnapshotHistory::clear() {
+    while (!mUndo.empty()) {
+        mRetained.remove(mUndo.back().rope);
+        mUndo.pop_back();
+    }
+    clear_redo();
+    mRetained.set_live(Rope());
+    seal();
+}
+
+void SnapshotHistory::set_budget(std::size_t bytes) {
+    mBudget = bytes;
+    enforce_budget();
+}
+
+std::size_t SnapshotHistory::budget() const { return mBudget; }
+
+std::size_t SnapshotHistory::retained_bytes() const {
+    return mRetained.bytes();
+}
+
+std::size_t SnapshotHistory::undo_count() const { return mUndo.size(); }
+
+std::size_t SnapshotHistory::redo_count() const { return mRedo.size(); }
+
+void SnapshotHistory::push_undo(Entry entry) {
+    entry.bytes = mRetained.add(entry.rope);
+    mUndo.push_back(std::move(entry));
+}
+
+void SnapshotHistory::clear_redo() {
+    for (const auto& entry : mRedo) mRetained.remove(entry.rope);
+    mRedo.clear();
+}
+
+void SnapshotHistory::enforce_budget() {
+    // always keep the latest entry so the last edit can be undone
+    while (mRetained.bytes() > mBudget && mUndo.size() > 1) {
+        mRetained.remove(mUndo.front().rope);
+        mUndo.pop_front();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef HISTORY_SNAPSHOT_HISTORY_HPP
+#define HISTORY_SNAPSHOT_HISTORY_HPP
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "history/backend.hpp"
+#include "history/retained_nodes.hpp"
+
+/**
+ * @brief Undo/redo history made of whole Rope versions.
+ * @details Versions share their untouched nodes, so an entry only costs the
+ * nodes its edit created. Consecutive typing (or backspacing) is coalesced
+ * into a single entry until the run is sealed, goes idle for a moment or
+ * grows too long. The bytes the entries retain beyond the document being
+ * edited are tracked, and the oldest entries are dropped once they exceed
+ * the memory budget.
+ */
+class SnapshotHistory : public UndoBackend {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t defaultBudget = 64 << 20;
+    static constexpr std::size_t maxRunLength = 64;
+    static constexpr Clock::duration runTimeout = std::chrono::seconds(1);
+
+    struct Entry {
+        Rope rope;
+        Cursor cursor;
+        history::EditKind kind{history::EditKind::Other};
+        std::size_t bytes{};
+    };
+
+    // Only the kind of the edit matters, the entry keeps `before` itself.
+    void record(const Rope& before, const Cursor& cursor,
+                const history::Edit& edit) override;
+
+    void seal() override;
+
+    // Swap the given state with the previous/next version, if any.
+    bool undo(Rope& rope, Cursor& cursor) override;
+    bool redo(Rope& rope, Cursor& cursor) override;
+
+    void clear() override;
+
+    void set_budget(std::size_t bytes);
+    std::size_t budget() const;
+
+    std::size_t retained_bytes() const override;
+    std::size_t undo_count() const override;
+    std::size_t redo_count() const override;
+
+private:
+    void push_undo(Entry entry);
+    void clear_redo();
+    void enforce_budget();
+
+    std::deque< Entry > mUndo{};
+    std::vector< Entry > mRedo{};
+
+    history::RetainedNodes mRetained{};
+    std::size_t mBudget{defaultBudget};
+
+    bool mRunOpen{false};
+    std::size_t mRunLength{0};
+    Clock::time_point mLastRecord{};
+};
+
+#endif  // HISTORY_SNAPSHOT_HISTORY_HPP
@@ -0,0 +1,326 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "history/operation_log.hpp"
+#include "history/serialize.hpp"
+#include "history/snapshot_history.hpp"
+#include "rope/builder.hpp"
+
+using history::Edit;
+using history::EditKind;
+
+void testCoalescing() {
+    SnapshotHistory history;
+    Rope rope("\n");
+    Cursor cursor{};
+
+    for (char c : std::string("hello world")) {
+        history.record(rope, cursor, Edit{EditKind::Typing});
+        rope = rope.insert(cursor.column++, std::string(1, c));
+        if (c == ' ') history.seal();
+    }
+
+    std::cout << "Typed:    " << rope;
+    std::cout << "Entries:  " << history.undo_count() << std::endl;
+
+    history.undo(rope, cursor);
+    std::cout << "Undo:     " << rope;
+    history.undo(rope, cursor);
+    std::cout << "Undo:     " << rope;
+    history.redo(rope, cursor);
+    std::cout << "Redo:     " << rope;
+}
+
+void testBudget() {
+    SnapshotHistory history;
+    history.set_budget(2 << 20);
+
+    Rope rope(std::string(2000, 'a') + "\n");
+    Cursor cursor{};
+
+    for (std::size_t i = 0; i < 2000; ++i) {
+        history.record(rope, cursor, Edit{EditKind::Style});
+        rope = rope.replace(i * 3 % rope.length(), 2, "bc");
+    }
+
+    std::cout << "Budget:   " << history.budget() << std::endl;
+    std::cout << "Retained: " << history.retained_bytes() << std::endl;
+    std::cout << "Entries:  " << history.undo_count() << std::endl;
+}
+
+void testLargeDocument() {
+    // the document alone is over the budget, its edits are not
+    SnapshotHistory history;
+    history.set_budget(8 << 20);
+
+    rope::Builder builder;
+    builder.append(nstring(std::string(200000, 'a') + "\n"));
+    Rope rope = builder.build();
+    Cursor cursor{};
+
+    for (std::size_t i = 0; i < 20; ++i) {
+        history.record(rope, cursor, Edit{EditKind::Style});
+        rope = rope.replace(i * 9999, 2, "bc");
+        history.seal();
+    }
+
+    std::cout << "Large:    " << history.undo_count() << " entries, under "
+              << (history.retained_bytes() < (8 << 20)) << std::endl;
+
+    history.undo(rope, cursor);
+    history.undo(rope, cursor);
+    std::cout << "Undone:   " << history.undo_count() << " "
+              << history.redo_count() << " entries, under "
+              << (history.retained_bytes() < (8 << 20)) << std::endl;
+}
+
+void testOperationLog() {
+    OperationLog log;
+    Rope rope("\n");
+    Cursor cursor{};
+
+    auto edit = [&](const Edit& edit) {
+        log.record(rope, cursor, edit);
+        rope = history::apply(rope, edit);
+    };
+
+    for (char c : std::string("hello world")) {
+        std::size_t end = rope.length() - 1;
+        edit({EditKind::Typing, end, nstring(), nstring(std::string(1, c))});
+        if (c == ' ') log.seal();
+    }
+    edit({EditKind::Erase, 10, nstring("d"), nstring()});
+    edit({EditKind::Erase, 9, nstring("l"), nstring()});
+
+    nstring bold = rope.subnstr(0, 5);
+    bold.toggleBold(0, bold.length());
+    edit({EditKind::Style, 0, rope.subnstr(0, 5), bold});
+
+    std::cout << "Edited:   " << rope;
+    std::cout << "Entries:  " << log.undo_count() << std::endl;
+
+    std::stringstream saved;
+    log.save(saved);
+
+    log.undo(rope, cursor);
+    std::cout << "Undo:     " << rope << "Bold:     " << rope[0].isBold()
+              << std::endl;
+    log.undo(rope, cursor);
+    std::cout << "Undo:     " << rope;
+    log.undo(rope, cursor);
+    std::cout << "Undo:     " << rope;
+    log.redo(rope, cursor);
+    std::cout << "Redo:     " << rope;
+
+    OperationLog loaded;
+    Rope replayed;
+    bool ok = loaded.load(saved, replayed);
+    std::cout << "Loaded:   " << ok << " " << replayed;
+    std::cout << "Bold:     " << replayed[0].isBold() << std::endl;
+    loaded.undo(replayed, cursor);
+    loaded.undo(replayed, cursor);
+    std::cout << "Undo:     " << replayed;
+}
+
+void testCheckpoints() {
+    OperationLog log;
+    log.set_max_entries(2 * OperationLog::checkpointInterval);
+
+    Rope rope(std::string(100, 'a') + "\n");
+    Cursor cursor{};
+
+    for (std::size_t i = 0; i < 5 * OperationLog::checkpointInterval; ++i) {
+        Edit edit{EditKind::Style, i * 7 % 99, rope.subnstr(i * 7 % 99, 1),
+                  nstring(std::string(1, 'a' + i % 26))};
+        log.record(rope, cursor, edit);
+        rope = history::apply(rope, edit);
+        if (!rope.is_balanced()) rope = rope.rebalance();
+    }
+
+    std::cout << "Entries:  " << log.undo_count() << std::endl;
+    std::cout << "Checkpoints: " << log.checkpoint_count() << std::endl;
+
+    std::stringstream saved;
+    log.save(saved);
+
+    OperationLog loaded;
+    Rope replayed;
+    loaded.load(saved, replayed);
+    std::cout << "Replayed: " << (replayed == rope) << std::endl;
+
+    while (log.undo(rope, cursor)) {
+    }
+    std::cout << "Oldest:   " << rope.substr(0, 10) << std::endl;
+}
+
+void testCombine() {
+    // rename an identifier on every line, as multiple cursors would
+    constexpr std::size_t lines = 10000;
+    std::string line = "    total = old_name + 1;\n";
+    std::size_t column = line.find("old_name");
+
+    rope::Builder builder;
+    std::vector< Rope::Splice > splices;
+    for (std::size_t i = 0; i < lines; ++i) {
+        std::size_t start = builder.length() + column;
+        builder.append(nstring(line));
+
+        // one erase across several leaves instead of 200 renames
+        if (i > 5000 && i < 5200) continue;
+        splices.push_back({start, 8, nstring("new_identifier")});
+    }
+    Rope rope = builder.build();
+
+    splices[5000].length = 200 * line.size();
+    splices[5000].text = Rope();
+    splices.push_back({rope.length(), 0, nstring("end")});
+
+    // the same splices one by one on a flat string, right to left
+    std::string expected = rope.to_string();
+    for (auto splice = splices.rbegin(); splice != splices.rend(); ++splice) {
+        expected.replace(splice->start, splice->length,
+                         splice->text.to_string());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Edit combined = history::combine(rope, splices);
+    Rope edited = history::apply(rope, combined);
+    double ms = std::chrono::duration< double, std::milli >(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+    std::cout << "Combined: " << (edited.to_string() == expected) << std::endl;
+    std::cout << "Reverted: " << (history::revert(edited, combined) == rope)
+              << std::endl;
+    std::cout << "Combine ms: " << ms << std::endl;
+
+    // the edit holds what changed, not the text between the ranges
+    std::size_t held = combined.removed.length();
+    for (const auto& other : combined.others) held += other.removed.length();
+    std::cout << "Combined holds: " << held << " of " << rope.length()
+              << std::endl;
+}
+
+std::size_t countBold(const Rope& rope) {
+    std::size_t count = 0;
+    rope.for_each_chunk([&](const nstring& chunk) {
+        for (std::size_t i = 0; i < chunk.length(); ++i) {
+            count += chunk[i].isBold();
+        }
+    });
+    return count;
+}
+
+void testRestyle() {
+    // bold on a million characters and off again, as Document does it
+    rope::Builder builder;
+    while (builder.length() < 1100000) {
+        builder.append(nstring("the quick brown fox jumps over the dog\n"));
+    }
+    Rope rope = builder.build();
+    std::size_t start = 100, length = 1000000;
+
+    auto begin = std::chrono::steady_clock::now();
+    Rope removed = rope.subrope(start, length);
+    bool on = !rope.has_type(start, length, nchar::Bold);
+    Edit edit{EditKind::Style, start, removed,
+              removed.restyle(0, length, StylePatch::type(nchar::Bold, on))};
+    Rope bold = history::apply(rope, edit);
+
+    bool off = bold.has_type(start, length, nchar::Bold);
+    Rope plain =
+        bold.restyle(start, length, StylePatch::type(nchar::Bold, !off));
+    double ms = std::chrono::duration< double, std::milli >(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+
+    // typing inside the bold range does not make the typed text bold
+    Rope typed = bold.splice({{start + 10, 0, nstring("x")}});
+
+    std::cout << "Restyled: "
+              << (on && off && countBold(bold) == length &&
+                  countBold(plain) == 0 && bold == rope)
+              << std::endl;
+    std::cout << "Unstyled: " << (countBold(history::revert(bold, edit)) == 0)
+              << std::endl;
+    std::cout << "Typed in: "
+              << (!typed[start + 10].isBold() && typed[start + 11].isBold())
+              << std::endl;
+    std::cout << "Restyle ms: " << ms << std::endl;
+}
+
+void testDiff() {
+    // an edit in the middle of a large document, and its undo
+    rope::Builder builder;
+    while (builder.length() < 1000000) builder.append(nstring("some text\n"));
+    Rope before = builder.build();
+    Edit typed{EditKind::Typing, 500003, Rope(), nstring("xyz")};
+    Rope after = history::apply(before, typed);
+
+    auto start = std::chrono::steady_clock::now();
+    Edit forward = history::diff(before, after);
+    Edit back = history::diff(after, before);
+    double ms = std::chrono::duration< double, std::milli >(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+    std::cout << "Diff: " << forward.position << " "
+              << forward.removed.length() << " " << forward.inserted
+              << std::endl;
+    std::cout << "Diff back: " << (history::apply(after, back) == before)
+              << std::endl;
+    std::cout << "Diff same: "
+              << history::diff(before, before).inserted.length() << std::endl;
+    std::cout << "Diff ms: " << ms << std::endl;
+}
+
+void testEncoding() {
+    // a paste of 100k characters, bold and linked here and there
+    nstring page;
+    for (int i = 0; i < 1000; ++i) {
+        nchar c(i % 50 == 49 ? '\n' : i % 7 ? 'a' + i % 26 : 0xE9);
+        if (i % 200 < 30) c.toggleBold();
+        if (i % 300 < 10) c.setLink("https://example.com");
+        page += c;
+    }
+    rope::Builder builder;
+    for (int i = 0; i < 100; ++i) builder.append(page);
+    Edit paste{EditKind::Other, 5, Rope(), builder.build()};
+
+    std::ostringstream out;
+    history::write_edit(out, paste);
+    std::string bytes = out.str();
+
+    std::istringstream in(bytes);
+    Edit read;
+    bool ok = history::read_edit(in, read);
+    nstring a = read.inserted.to_nstring();
+    nstring b = paste.inserted.to_nstring();
+    bool same = a.length() == b.length();
+    for (std::size_t i = 0; same && i < a.length(); ++i) {
+        same = a[i] == b[i] && a[i].sameStyle(b[i]);
+    }
+
+    std::cout << "Encoded: " << ok << " " << same << " "
+              << (bytes.size() < 2 * paste.inserted.length()) << std::endl;
+
+    // a truncated record is rejected, not misread
+    std::istringstream torn(bytes.substr(0, bytes.size() / 2));
+    std::cout << "Truncated: " << !history::read_edit(torn, read)
+              << std::endl;
+}
+
+int main() {
+    testCoalescing();
+    testBudget();
+    testLargeDocument();
+    testOperationLog();
+    testCheckpoints();
+    testCombine();
+    testDiff();
+    testEncoding();
+    testRestyle();
+
+    return 0;
+}
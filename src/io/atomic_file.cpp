@@ -0,0 +1,106 @@
+#include "io/atomic_file.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace io {
+
+    AtomicFile::AtomicFile(const std::string& path)
+        : mPath{path}, mTempPath{path + ".XXXXXX"} {
+        mFd = ::mkstemp(mTempPath.data());
+        if (mFd < 0) fail("Could not create a temporary file for");
+
+        // keep the permissions of the file being replaced
+        struct stat info {};
+        mode_t mode = ::stat(mPath.c_str(), &info) == 0
+                          ? info.st_mode & 07777
+                          : 0644;
+        ::fchmod(mFd, mode);
+
+        mBuffer.reserve(bufferSize);
+    }
+
+    AtomicFile::~AtomicFile() {
+        if (mFd < 0) return;
+        ::close(mFd);
+        ::unlink(mTempPath.c_str());
+    }
+
+    void AtomicFile::write(const char* data, std::size_t size) {
+        mSize += size;
+        if (mBuffer.size() + size > bufferSize) flush();
+
+        // large writes skip the buffer
+        if (size >= bufferSize) {
+            while (size > 0) {
+                ssize_t written = ::write(mFd, data, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written < 0) fail("Could not write");
+                data += written;
+                size -= written;
+            }
+            return;
+        }
+
+        mBuffer.insert(mBuffer.end(), data, data + size);
+    }
+
+    void AtomicFile::write(const std::string& data) {
+        write(data.data(), data.size());
+    }
+
+    std::size_t AtomicFile::size() const { return mSize; }
+
+    void AtomicFile::commit() {
+        flush();
+        if (::fsync(mFd) != 0) fail("Could not sync");
+
+        int fd = mFd;
+        mFd = -1;
+        if (::close(fd) != 0) {
+            ::unlink(mTempPath.c_str());
+            fail("Could not close");
+        }
+
+        if (::rename(mTempPath.c_str(), mPath.c_str()) != 0) {
+            ::unlink(mTempPath.c_str());
+            fail("Could not replace");
+        }
+
+        // make the rename itself durable
+        std::string::size_type slash = mPath.find_last_of('/');
+        std::string directory =
+            slash == std::string::npos ? "." : mPath.substr(0, slash + 1);
+        int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+
+    void AtomicFile::flush() {
+        const char* data = mBuffer.data();
+        std::size_t size = mBuffer.size();
+
+        while (size > 0) {
+            ssize_t written = ::write(mFd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written < 0) fail("Could not write");
+            data += written;
+            size -= written;
+        }
+        mBuffer.clear();
+    }
+
+    void AtomicFile::fail(const std::string& what) const {
+        throw std::runtime_error(what + " " + mPath + ": " +
+                                 std::strerror(errno));
+    }
+
+}  // namespace io
@@ -0,0 +1,49 @@
+#ifndef IO_ATOMIC_FILE_HPP
+#define IO_ATOMIC_FILE_HPP
+
+#include <string>
+#include <vector>
+
+namespace io {
+
+    /**
+     * @brief Writes a file so that readers see either the old or the new
+     * content, never a mix, even after a crash.
+     * @details Data goes to a temporary file next to the target, through a
+     * buffer. commit() flushes it, fsyncs it, renames it over the target and
+     * fsyncs the directory. Without a commit the temporary file is removed.
+     * Every failure throws std::runtime_error.
+     */
+    class AtomicFile {
+    public:
+        static constexpr std::size_t bufferSize = 1 << 16;
+
+        explicit AtomicFile(const std::string& path);
+        ~AtomicFile();
+
+        AtomicFile(const AtomicFile&) = delete;
+        AtomicFile& operator=(const AtomicFile&) = delete;
+
+        void write(const char* data, std::size_t size);
+        void write(const std::string& data);
+
+        // Bytes written so far, buffered ones included
+        std::size_t size() const;
+
+        void commit();
+
+    private:
+        void flush();
+        [[noreturn]] void fail(const std::string& what) const;
+
+        std::string mPath{};
+        std::string mTempPath{};
+        int mFd{-1};
+
+        std::vector< char > mBuffer{};
+        std::size_t mSize{0};
+    };
+
+}  // namespace io
+
+#endif  // IO_ATOMIC_FILE_HPP
@@ -0,0 +1,332 @@
+#include "io/journal.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include "history/serialize.hpp"
+#include "io/atomic_file.hpp"
+#include "io/native_file.hpp"
+
+namespace io {
+
+    namespace {
+        constexpr char magic[4] = {'J', 'R', 'N', 'L'};
+        constexpr std::uint32_t version = 3;
+
+        // FNV-1a, enough to tell a torn record from a whole one
+        std::uint32_t checksum(const std::string& data) {
+            std::uint32_t hash = 2166136261u;
+            for (char c : data) {
+                hash ^= static_cast< std::uint8_t >(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        std::string snapshot_path(const std::string& path,
+                                  std::uint64_t generation) {
+            return path + "." + std::to_string(generation);
+        }
+
+        // Generation of the journal in `in`, 0 if it is not one
+        std::uint64_t read_header(std::istream& in) {
+            char header[sizeof(magic)]{};
+            std::uint32_t fileVersion{};
+            std::uint64_t generation{};
+
+            if (!in.read(header, sizeof(header)) ||
+                !std::equal(header, header + sizeof(header), magic) ||
+                !history::read_value(in, fileVersion) ||
+                fileVersion != version ||
+                !history::read_value(in, generation)) {
+                return 0;
+            }
+            return generation;
+        }
+
+        template < typename T >
+        void append_value(std::string& out, T value) {
+            out.append(reinterpret_cast< const char* >(&value), sizeof(value));
+        }
+    }  // namespace
+
+    Journal::Journal(const std::string& path, const Rope& base)
+        : mPath{path} {
+        // continue the numbering of a journal left there, a snapshot it
+        // still refers to must not be overwritten
+        std::ifstream previous(path, std::ios::binary);
+        mGeneration = read_header(previous);
+
+        mQueue.push_back(base);
+        mWorker = std::thread(&Journal::run, this);
+    }
+
+    Journal::~Journal() {
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+        }
+        mWake.notify_one();
+
+        if (mWorker.joinable()) mWorker.join();
+        if (mFd >= 0) ::close(mFd);
+    }
+
+    void Journal::append(history::Edit edit) {
+        {
+            std::lock_guard lock(mMutex);
+            if (mStopping) return;
+            mQueue.emplace_back(std::move(edit));
+        }
+        mWake.notify_one();
+    }
+
+    void Journal::reset(const Rope& rope) {
+        {
+            std::lock_guard lock(mMutex);
+            if (mStopping) return;
+            mQueue.emplace_back(rope);
+            mError.clear();
+        }
+        mWake.notify_one();
+    }
+
+    void Journal::discard() {
+        {
+            std::lock_guard lock(mMutex);
+            mQueue.clear();
+            mStopping = true;
+            mDiscarding = true;
+        }
+        mWake.notify_one();
+
+        if (mWorker.joinable()) mWorker.join();
+        if (mFd >= 0) ::close(mFd);
+        mFd = -1;
+
+        std::remove(mPath.c_str());
+        if (mGeneration) {
+            std::remove(snapshot_path(mPath, mGeneration).c_str());
+        }
+    }
+
+    void Journal::wait_idle() {
+        std::unique_lock lock(mMutex);
+        mIdle.wait(lock, [&]() { return !mWriting && mQueue.empty(); });
+    }
+
+    std::size_t Journal::committed() const {
+        std::lock_guard lock(mMutex);
+        return mCommitted;
+    }
+
+    std::size_t Journal::compactions() const {
+        std::lock_guard lock(mMutex);
+        return mCompactions;
+    }
+
+    std::string Journal::error() const {
+        std::lock_guard lock(mMutex);
+        return mError;
+    }
+
+    std::optional< Rope > Journal::recover(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::uint64_t generation = read_header(in);
+        if (!generation) return std::nullopt;
+
+        Rope rope;
+        try {
+            rope = load_native(snapshot_path(path, generation));
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+
+        // a torn size must not be allocated
+        std::streampos records = in.tellg();
+        in.seekg(0, std::ios::end);
+        std::uint64_t end = in.tellg();
+        in.seekg(records);
+
+        std::string payload;
+        while (true) {
+            std::uint64_t size{};
+            std::uint32_t sum{};
+            if (!history::read_value(in, size) ||
+                !history::read_value(in, sum) ||
+                size > end - static_cast< std::uint64_t >(in.tellg())) {
+                break;
+            }
+
+            payload.resize(size);
+            if (!in.read(payload.data(), size) || checksum(payload) != sum) {
+                break;
+            }
+
+            std::istringstream record(payload);
+            history::Edit edit;
+            if (!history::read_edit(record, edit)) break;
+
+            // the last range ends furthest
+            std::size_t end = edit.position + edit.removed.length();
+            if (!edit.others.empty()) {
+                const history::Change& last = edit.others.back();
+                end = last.position + last.removed.length();
+            }
+            if (end > rope.length()) break;
+
+            rope = history::apply(rope, edit);
+            if (!rope.is_balanced()) rope = rope.rebalance();
+        }
+
+        return rope;
+    }
+
+    void Journal::remove(const std::string& path) {
+        std::uint64_t generation = 0;
+        {
+            std::ifstream in(path, std::ios::binary);
+            generation = read_header(in);
+        }
+
+        std::remove(path.c_str());
+        if (generation) std::remove(snapshot_path(path, generation).c_str());
+    }
+
+    void Journal::run() {
+        std::unique_lock lock(mMutex);
+
+        while (true) {
+            mWake.wait(lock, [&]() { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty() || mDiscarding) return;
+
+            std::vector< Operation > batch;
+            batch.swap(mQueue);
+            mWriting = true;
+            lock.unlock();
+
+            std::size_t edits = 0;
+            std::string error;
+            try {
+                std::string records;
+                std::ostringstream payload;
+
+                // everything before the last reset is part of its
+                // snapshot, only that one is written
+                auto last = std::find_if(
+                    batch.rbegin(), batch.rend(), [](const auto& operation) {
+                        return std::holds_alternative< Rope >(operation);
+                    });
+                auto first = last == batch.rend() ? batch.begin()
+                                                  : std::prev(last.base());
+
+                for (auto it = first; it != batch.end(); ++it) {
+                    if (auto rope = std::get_if< Rope >(&*it)) {
+                        compact(*rope);
+                        continue;
+                    }
+
+                    const auto& edit = std::get< history::Edit >(*it);
+                    mReplica = history::apply(mReplica, edit);
+                    if (!mReplica.is_balanced()) {
+                        mReplica = mReplica.rebalance();
+                    }
+
+                    payload.str("");
+                    history::write_edit(payload, edit);
+                    std::string data = payload.str();
+
+                    append_value(records, static_cast< std::uint64_t >(
+                                              data.size()));
+                    append_value(records, checksum(data));
+                    records += data;
+                    ++edits;
+                    ++mRecords;
+                }
+
+                // one sync for the whole batch, nothing is written after an
+                // error until a reset
+                if (mFd < 0) edits = 0;
+                write(records);
+                if (mFd >= 0 && mRecords >= compactInterval) {
+                    compact(mReplica);
+                }
+            } catch (const std::runtime_error& exception) {
+                // the replica may no longer match the document, stop
+                // writing records until the next reset() starts over
+                error = exception.what();
+                edits = 0;
+                if (mFd >= 0) ::close(mFd);
+                mFd = -1;
+            }
+
+            lock.lock();
+            mCommitted += edits;
+            if (!error.empty()) mError = error;
+            mWriting = false;
+            if (mQueue.empty()) mIdle.notify_all();
+        }
+    }
+
+    void Journal::compact(const Rope& rope) {
+        std::uint64_t generation = mGeneration + 1;
+        save_native(rope, snapshot_path(mPath, generation));
+
+        AtomicFile journal(mPath);
+        journal.write(magic, sizeof(magic));
+        journal.write(reinterpret_cast< const char* >(&version),
+                      sizeof(version));
+        journal.write(reinterpret_cast< const char* >(&generation),
+                      sizeof(generation));
+        journal.commit();
+
+        if (mFd >= 0) ::close(mFd);
+        mFd = ::open(mPath.c_str(), O_WRONLY | O_APPEND);
+        if (mFd < 0) {
+            throw std::runtime_error("Could not open journal " + mPath +
+                                     ": " + std::strerror(errno));
+        }
+
+        if (mGeneration) {
+            std::remove(snapshot_path(mPath, mGeneration).c_str());
+        }
+        mGeneration = generation;
+        mReplica = rope;
+        mRecords = 0;
+
+        std::lock_guard lock(mMutex);
+        ++mCompactions;
+    }
+
+    void Journal::write(const std::string& records) {
+        if (records.empty() || mFd < 0) return;
+
+        const char* data = records.data();
+        std::size_t size = records.size();
+        while (size > 0) {
+            ssize_t written = ::write(mFd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written < 0) {
+                throw std::runtime_error("Could not write journal " + mPath +
+                                         ": " + std::strerror(errno));
+            }
+            data += written;
+            size -= written;
+        }
+
+        if (::fdatasync(mFd) != 0) {
+            throw std::runtime_error("Could not sync journal " + mPath +
+                                     ": " + std::strerror(errno));
+        }
+    }
+
+}  // namespace io
@@ -0,0 +1,108 @@
+#ifndef IO_JOURNAL_HPP
+#define IO_JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "history/backend.hpp"
+#include "rope/rope.hpp"
+
+namespace io {
+
+    /**
+     * @brief Crash-safe autosave: an append-only journal of edits on top of
+     * a snapshot of the document.
+     * @details The UI thread only queues edits, everything else happens on
+     * a worker thread. The worker writes whatever is queued as one batch
+     * with a single fdatasync (group commit), so a burst of keystrokes costs
+     * one sync. It keeps a replica of the document by applying the edits,
+     * and every compactInterval edits writes the replica as a native
+     * snapshot and starts an empty journal on top of it. reset() does the
+     * same with a state given by the document, for changes that are not
+     * edits (a save); of several resets in one batch only the last is
+     * written.
+     *
+     * Files: `path` holds a header naming the snapshot generation, then
+     * records of u64 size, u32 checksum and an encoded history::Edit.
+     * `path.<generation>` is the snapshot. A new snapshot is written before
+     * the journal that refers to it replaces the old one, so a crash at any
+     * point leaves a journal and the snapshot it applies to. A torn record
+     * at the end fails its checksum and is ignored.
+     */
+    class Journal {
+    public:
+        static constexpr std::size_t compactInterval = 4096;
+
+        // Starts a journal whose snapshot is `base`, replacing any other.
+        Journal(const std::string& path, const Rope& base);
+        ~Journal();
+
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+        void append(history::Edit edit);
+
+        // The document changed to `rope` other than by edits. Also starts
+        // over after an error, which it clears.
+        void reset(const Rope& rope);
+
+        // Stop journaling and remove the files, the work was saved.
+        void discard();
+
+        void wait_idle();
+
+        // Edits written to disk since the journal was started
+        std::size_t committed() const;
+        std::size_t compactions() const;
+        // Last I/O error of the worker since the last reset(), empty if
+        // none. Edits are not written after one until the next reset().
+        std::string error() const;
+
+        /**
+         * @brief The document as journaled at `path`, if a journal is there.
+         * @return The snapshot with every intact record replayed on top.
+         */
+        static std::optional< Rope > recover(const std::string& path);
+
+        // Removes the journal at `path` and its snapshot, e.g. one whose
+        // recovery was declined
+        static void remove(const std::string& path);
+
+    private:
+        using Operation = std::variant< history::Edit, Rope >;
+
+        void run();
+        void compact(const Rope& rope);
+        void write(const std::string& records);
+
+        std::string mPath{};
+
+        mutable std::mutex mMutex{};
+        std::condition_variable mWake{};
+        std::condition_variable mIdle{};
+        std::vector< Operation > mQueue{};
+        bool mWriting{false};
+        bool mStopping{false};
+        bool mDiscarding{false};
+        std::size_t mCommitted{0};
+        std::size_t mCompactions{0};
+        std::string mError{};
+
+        // only touched by the worker
+        Rope mReplica{};
+        std::uint64_t mGeneration{0};
+        std::size_t mRecords{0};
+        int mFd{-1};
+
+        std::thread mWorker{};
+    };
+
+}  // namespace io
+
+#endif  // IO_JOURNAL_HPP
@@ -0,0 +1,63 @@
+#include "io/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace io {
+
+    std::shared_ptr< const MappedFile > MappedFile::open(
+        const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open file: " + path + ": " +
+                                     std::strerror(errno));
+        }
+
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Could not stat file: " + path + ": " +
+                                     std::strerror(error));
+        }
+
+        std::size_t size = info.st_size;
+        const char* data = nullptr;
+
+        // mmap rejects empty mappings, an empty file simply has no data
+        if (size > 0) {
+            void* mapping =
+                ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("Could not map file: " + path +
+                                         ": " + std::strerror(error));
+            }
+            // the text is read front to back, mostly once
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            data = static_cast< const char* >(mapping);
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+        return std::shared_ptr< const MappedFile >(new MappedFile(data, size));
+    }
+
+    MappedFile::MappedFile(const char* data, std::size_t size)
+        : mData{data}, mSize{size} {}
+
+    MappedFile::~MappedFile() {
+        if (mData) ::munmap(const_cast< char* >(mData), mSize);
+    }
+
+    const char* MappedFile::data() const { return mData; }
+
+    std::size_t MappedFile::size() const { return mSize; }
+
+}  // namespace io
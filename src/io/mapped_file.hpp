@@ -0,0 +1,37 @@
+#ifndef IO_MAPPED_FILE_HPP
+#define IO_MAPPED_FILE_HPP
+
+#include <memory>
+#include <string>
+
+namespace io {
+
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     * @details Owned through shared_ptr so that every rope leaf pointing into
+     * the mapping keeps it alive; the file is unmapped when the last one goes
+     * away.
+     */
+    class MappedFile {
+    public:
+        // Throws std::runtime_error if the file cannot be opened or mapped.
+        static std::shared_ptr< const MappedFile > open(
+            const std::string& path);
+
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const;
+        std::size_t size() const;
+
+    private:
+        MappedFile(const char* data, std::size_t size);
+
+        const char* mData{};
+        std::size_t mSize{};
+    };
+
+}  // namespace io
+
+#endif  // IO_MAPPED_FILE_HPP
@@ -0,0 +1,127 @@
+#include "io/mapped_text.hpp"
+
+#include <vector>
+
+namespace io {
+
+    MappedText::MappedText(const std::string& path)
+        : mFile{MappedFile::open(path)} {
+        mPreviewEnd = next_cut(0);
+
+        std::vector< rope::Node::Ptr > leaves;
+        if (mPreviewEnd > 0) leaves.push_back(make_leaf(0, mPreviewEnd));
+        if (mPreviewEnd < mFile->size() || !ends_with_newline()) {
+            leaves.push_back(std::make_shared< rope::Leaf >(nstring("\n")));
+        }
+        mPreview = Rope::from_leaves(leaves);
+
+        // the newline added to an unfinished preview is not in the file
+        bool partial = mPreviewEnd < mFile->size();
+        mIndexedBytes = mPreviewEnd;
+        mIndexedLines = partial ? leaves.front()->line_count()
+                                : mPreview.line_count();
+        if (partial) {
+            mWorker = std::thread(&MappedText::run, this);
+        } else {
+            mResult = mPreview;
+            mDone = true;
+        }
+    }
+
+    MappedText::~MappedText() {
+        mStopping = true;
+        if (mWorker.joinable()) mWorker.join();
+    }
+
+    const Rope& MappedText::preview() const { return mPreview; }
+
+    MappedText::Progress MappedText::progress() const {
+        Progress progress{};
+        progress.done = mDone;
+        progress.bytes = mIndexedBytes;
+        progress.totalBytes = mFile->size();
+        progress.lines = mIndexedLines;
+
+        if (progress.done || progress.bytes == 0) {
+            progress.estimatedLines = progress.lines;
+        } else {
+            progress.estimatedLines = static_cast< std::size_t >(
+                static_cast< double >(progress.lines) * progress.totalBytes /
+                progress.bytes);
+        }
+        return progress;
+    }
+
+    std::optional< Rope > MappedText::take_result() {
+        if (!mDone) return std::nullopt;
+
+        std::lock_guard< std::mutex > lock(mMutex);
+        std::optional< Rope > result = std::move(mResult);
+        mResult.reset();
+        return result;
+    }
+
+    void MappedText::run() {
+        // the preview leaf is shared with the full rope, its newline is not
+        std::vector< rope::Node::Ptr > leaves = mPreview.root()->leaves();
+        leaves.pop_back();
+
+        std::size_t lines = mIndexedLines;
+        for (std::size_t begin = mPreviewEnd; begin < mFile->size();) {
+            if (mStopping) return;
+
+            std::size_t end = next_cut(begin);
+            leaves.push_back(make_leaf(begin, end));
+            lines += leaves.back()->line_count();
+
+            // lines first, so the estimate never divides by stale bytes
+            mIndexedLines.store(lines, std::memory_order_relaxed);
+            mIndexedBytes.store(end, std::memory_order_relaxed);
+            begin = end;
+        }
+
+        if (!ends_with_newline()) {
+            leaves.push_back(std::make_shared< rope::Leaf >(nstring("\n")));
+        }
+
+        {
+            std::lock_guard< std::mutex > lock(mMutex);
+            mResult = Rope::from_leaves(leaves);
+            mIndexedLines = mResult->line_count();
+        }
+        mDone = true;
+    }
+
+    std::size_t MappedText::next_cut(std::size_t offset) const {
+        const char* data = mFile->data();
+        std::size_t size = mFile->size();
+
+        std::size_t cut = offset + chunkSize;
+        if (cut >= size) return size;
+
+        // cut before the lead byte of a UTF-8 sequence, and not inside a
+        // "\r\n", so each chunk decodes the same on its own
+        for (int i = 0; i < 3 && (data[cut] & 0xC0) == 0x80; ++i) --cut;
+        if (data[cut - 1] == '\r' && data[cut] == '\n') ++cut;
+
+        return cut;
+    }
+
+    rope::Node::Ptr MappedText::make_leaf(std::size_t begin,
+                                          std::size_t end) const {
+        const char* data = mFile->data() + begin;
+
+        // the leaf keeps the whole mapping alive
+        std::shared_ptr< const char > bytes(mFile, data);
+        return std::make_shared< rope::MappedLeaf >(
+            std::move(bytes), end - begin,
+            rope::MappedLeaf::measure(data, end - begin));
+    }
+
+    bool MappedText::ends_with_newline() const {
+        if (mFile->size() == 0) return false;
+        char last = mFile->data()[mFile->size() - 1];
+        return last == '\n' || last == '\r';
+    }
+
+}  // namespace io
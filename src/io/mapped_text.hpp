@@ -0,0 +1,76 @@
+#ifndef IO_MAPPED_TEXT_HPP
+#define IO_MAPPED_TEXT_HPP
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "io/mapped_file.hpp"
+#include "rope/rope.hpp"
+
+namespace io {
+
+    /**
+     * @brief A mapped text file whose rope is indexed in the background.
+     * @details Opening maps the file and measures only its first chunk, so a
+     * preview of the beginning is available right away whatever the file
+     * size. A worker thread then measures the remaining chunks, counting
+     * codepoints, lines and words without decoding them into nchars, and
+     * assembles a balanced rope of rope::MappedLeaf over the whole file.
+     * Until it is done, progress() extrapolates the line count from the
+     * bytes indexed so far.
+     */
+    class MappedText {
+    public:
+        static constexpr std::size_t chunkSize = 64 << 10;
+
+        struct Progress {
+            std::size_t bytes{};
+            std::size_t totalBytes{};
+            std::size_t lines{};
+            std::size_t estimatedLines{};
+            bool done{};
+        };
+
+        // Throws std::runtime_error if the file cannot be mapped.
+        explicit MappedText(const std::string& path);
+        ~MappedText();
+
+        MappedText(const MappedText&) = delete;
+        MappedText& operator=(const MappedText&) = delete;
+
+        // The first chunk of the file, ending in a newline
+        const Rope& preview() const;
+
+        Progress progress() const;
+
+        // The rope over the whole file once indexing is done, nothing before
+        // that or after it was taken once.
+        std::optional< Rope > take_result();
+
+    private:
+        void run();
+        std::size_t next_cut(std::size_t offset) const;
+        rope::Node::Ptr make_leaf(std::size_t begin, std::size_t end) const;
+        bool ends_with_newline() const;
+
+        std::shared_ptr< const MappedFile > mFile{};
+        Rope mPreview{};
+        std::size_t mPreviewEnd{0};
+
+        std::atomic< std::size_t > mIndexedBytes{0};
+        std::atomic< std::size_t > mIndexedLines{0};
+        std::atomic< bool > mDone{false};
+        std::atomic< bool > mStopping{false};
+
+        std::mutex mMutex{};
+        std::optional< Rope > mResult{};
+
+        std::thread mWorker{};
+    };
+
+}  // namespace io
+
+#endif  // IO_MAPPED_TEXT_HPP
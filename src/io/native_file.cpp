@@ -0,0 +1,416 @@
+#include "io/native_file.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "io/atomic_file.hpp"
+#include "io/mapped_file.hpp"
+#include "text/style_table.hpp"
+#include "text/utf8.hpp"
+
+namespace io {
+
+    namespace {
+        constexpr char magic[4] = {'N', 'D', 'O', 'C'};
+        constexpr std::uint32_t version = 1;
+
+        constexpr std::size_t headerSize = sizeof(magic) + 4;
+        constexpr std::size_t trailerSize = 8 + 8 + sizeof(magic);
+        constexpr std::size_t runSize = 8;
+        constexpr std::size_t chunkSize = 8 + 6 * 4;
+
+        struct Run {
+            std::uint32_t length{};
+            std::uint32_t style{};
+        };
+
+        struct Chunk {
+            std::uint64_t textOffset{};
+            std::uint32_t bytes{};
+            std::uint32_t length{};
+            std::uint32_t lines{};
+            std::uint32_t words{};
+            std::uint32_t firstRun{};
+            std::uint32_t runs{};
+        };
+
+        template < typename T >
+        void put(std::string& out, T value) {
+            out.append(reinterpret_cast< const char* >(&value), sizeof(value));
+        }
+
+        // What the chunk stylers share, alive as long as any leaf is
+        struct Styles {
+            std::shared_ptr< const MappedFile > file;
+            std::size_t runsOffset{};
+            std::size_t runCount{};
+            std::vector< nchar > styles{};
+
+            Run run(std::size_t index) const {
+                Run run{};
+                std::memcpy(&run, file->data() + runsOffset + index * runSize,
+                            runSize);
+                return run;
+            }
+
+            void apply(nstring& text, std::size_t firstRun,
+                       std::size_t runs) const {
+                std::size_t index = 0;
+                for (std::size_t i = firstRun; i < firstRun + runs; ++i) {
+                    Run run = this->run(i);
+                    std::size_t end =
+                        std::min< std::size_t >(index + run.length,
+                                                text.length());
+
+                    // a broken run leaves its characters unstyled
+                    if (run.style >= styles.size()) {
+                        index = end;
+                        continue;
+                    }
+
+                    const nchar& style = styles[run.style];
+                    for (; index < end; ++index) {
+                        int at = static_cast< int >(index);
+                        text[at] = nchar(text[at].codepoint(), style);
+                    }
+                }
+            }
+        };
+
+        // Styles one chunk. A named type, so that the writer recognizes the
+        // leaves of a native document and copies their runs.
+        struct ChunkStyler {
+            std::shared_ptr< const Styles > styles;
+            std::uint32_t firstRun{};
+            std::uint32_t runs{};
+
+            void operator()(nstring& text) const {
+                styles->apply(text, firstRun, runs);
+            }
+        };
+
+        // Streams chunks to the file and collects the runs and tables,
+        // which are written after the text.
+        class Writer {
+        public:
+            explicit Writer(const std::string& path) : mFile{path} {
+                mFile.write(magic, sizeof(magic));
+                mFile.write(reinterpret_cast< const char* >(&version),
+                            sizeof(version));
+            }
+
+            void add(const rope::Node& leaf) {
+                if (leaf.length() == 0) return;
+
+                // mapped leaves are copied without decoding them, unless
+                // their styles come from elsewhere
+                auto mapped = dynamic_cast< const rope::MappedLeaf* >(&leaf);
+                if (mapped && (!mapped->styler() ||
+                               mapped->styler().target< ChunkStyler >())) {
+                    add_mapped(*mapped);
+                } else {
+                    add_text(leaf);
+                }
+            }
+
+            std::size_t finish() {
+                std::uint64_t runsOffset = mFile.size();
+                mFile.write(reinterpret_cast< const char* >(mRuns.data()),
+                            mRuns.size() * sizeof(Run));
+
+                std::uint64_t tablesOffset = mFile.size();
+                std::string tables;
+                mStyles.write(tables);
+
+                put(tables, static_cast< std::uint64_t >(mChunks.size()));
+                for (const auto& chunk : mChunks) {
+                    put(tables, chunk.textOffset);
+                    put(tables, chunk.bytes);
+                    put(tables, chunk.length);
+                    put(tables, chunk.lines);
+                    put(tables, chunk.words);
+                    put(tables, chunk.firstRun);
+                    put(tables, chunk.runs);
+                }
+
+                put(tables, runsOffset);
+                put(tables, tablesOffset);
+                tables.append(magic, sizeof(magic));
+                mFile.write(tables);
+
+                mFile.commit();
+                return mFile.size();
+            }
+
+        private:
+            void add_text(const rope::Node& leaf) {
+                Chunk chunk = start_chunk(leaf);
+
+                mText.clear();
+                bool carriageReturn = false;
+                int previous = 0;
+
+                leaf.for_each_chunk([&](const nstring& text) {
+                    std::size_t length = text.length();
+                    for (std::size_t start = 0; start < length;) {
+                        // a run of one style, its text encoded in one go
+                        const nchar& style = text[start];
+                        std::size_t end = start + 1;
+                        while (end < length && text[end].sameStyle(style)) {
+                            ++end;
+                        }
+
+                        // runs count the characters the reader decodes,
+                        // where "\r\n" is one
+                        std::uint32_t decoded = 0;
+                        for (std::size_t i = start; i < end; ++i) {
+                            int codepoint = text[i].codepoint();
+                            carriageReturn |= codepoint == '\r';
+                            if (codepoint != '\n' || previous != '\r') {
+                                ++decoded;
+                            }
+                            previous = codepoint;
+
+                            if (codepoint < 0x80) {
+                                mText += static_cast< char >(codepoint);
+                            } else {
+                                utf8::append(mText, codepoint);
+                            }
+                        }
+
+                        if (decoded) {
+                            mRuns.push_back({decoded, style_of(style)});
+                        }
+                        start = end;
+                    }
+                });
+
+                // the reader decodes chunks like text files, where "\r"
+                // ends a line, so count what it will see
+                if (carriageReturn) {
+                    auto metrics =
+                        rope::MappedLeaf::measure(mText.data(), mText.size());
+                    chunk.length = metrics.length;
+                    chunk.lines = metrics.lines;
+                    chunk.words = metrics.words;
+                }
+
+                chunk.bytes = mText.size();
+                chunk.runs = mRuns.size() - chunk.firstRun;
+                mChunks.push_back(chunk);
+                mFile.write(mText);
+            }
+
+            void add_mapped(const rope::MappedLeaf& leaf) {
+                Chunk chunk = start_chunk(leaf);
+                chunk.bytes = leaf.raw_size();
+
+                if (auto source = leaf.styler().target< ChunkStyler >()) {
+                    const Styles& styles = *source->styles;
+                    for (std::uint32_t i = 0; i < source->runs; ++i) {
+                        Run run = styles.run(source->firstRun + i);
+                        mRuns.push_back({run.length, remap(styles, run.style)});
+                    }
+                } else {
+                    // plain text, decoded with the default attributes
+                    mRuns.push_back({chunk.length, mStyles.add(nchar())});
+                }
+
+                chunk.runs = mRuns.size() - chunk.firstRun;
+                mChunks.push_back(chunk);
+                mFile.write(leaf.raw_data(), leaf.raw_size());
+            }
+
+            Chunk start_chunk(const rope::Node& leaf) {
+                Chunk chunk{};
+                chunk.textOffset = mFile.size();
+                chunk.length = leaf.length();
+                chunk.lines = leaf.line_count();
+                chunk.words = leaf.word_count();
+                chunk.firstRun = mRuns.size();
+                return chunk;
+            }
+
+            // Index of the style of c. Text switches between a few styles
+            // (bold words, links), so the last ones are compared before
+            // building the key of the table.
+            std::uint32_t style_of(const nchar& c) {
+                for (std::size_t i = 0; i < mRecent.size(); ++i) {
+                    if (mRecent[i].first.sameStyle(c)) {
+                        std::rotate(mRecent.begin(), mRecent.begin() + i,
+                                    mRecent.begin() + i + 1);
+                        return mRecent.front().second;
+                    }
+                }
+
+                if (mRecent.size() == recentStyles) mRecent.pop_back();
+                mRecent.insert(mRecent.begin(), {c, mStyles.add(c)});
+                return mRecent.front().second;
+            }
+
+            // Index in this file of a style of a loaded document
+            std::uint32_t remap(const Styles& styles, std::uint32_t style) {
+                if (style >= styles.styles.size()) return mStyles.add(nchar());
+
+                auto& remapped = mRemapped[&styles];
+                if (remapped.empty()) remapped.resize(styles.styles.size(), -1);
+                if (remapped[style] == static_cast< std::uint32_t >(-1)) {
+                    remapped[style] = mStyles.add(styles.styles[style]);
+                }
+                return remapped[style];
+            }
+
+            AtomicFile mFile;
+            std::string mText{};
+
+            std::vector< Run > mRuns{};
+            std::vector< Chunk > mChunks{};
+            StyleTable mStyles{};
+
+            static constexpr std::size_t recentStyles = 8;
+            std::vector< std::pair< nchar, std::uint32_t > > mRecent{};
+
+            // style indices of the loaded documents being copied
+            std::unordered_map< const Styles*, std::vector< std::uint32_t > >
+                mRemapped{};
+        };
+
+        // Bounds-checked reads from the mapping
+        class Reader {
+        public:
+            Reader(const MappedFile& file, const std::string& path)
+                : mData{file.data()}, mSize{file.size()}, mPath{path} {}
+
+            void seek(std::size_t position) {
+                if (position > mSize) fail();
+                mPosition = position;
+            }
+
+            std::size_t position() const { return mPosition; }
+
+            template < typename T >
+            T get() {
+                T value{};
+                std::memcpy(&value, take(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+            bool has_magic() {
+                return std::equal(magic, magic + sizeof(magic),
+                                  take(sizeof(magic)));
+            }
+
+            [[noreturn]] void fail() const {
+                throw std::runtime_error("Could not read document: " + mPath);
+            }
+
+        private:
+            const char* take(std::size_t size) {
+                if (size > mSize - mPosition) fail();
+                const char* data = mData + mPosition;
+                mPosition += size;
+                return data;
+            }
+
+            const char* mData{};
+            std::size_t mSize{};
+            std::size_t mPosition{0};
+            const std::string& mPath;
+        };
+
+    }  // namespace
+
+    bool is_native(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        char header[sizeof(magic)]{};
+        return file.read(header, sizeof(header)) &&
+               std::equal(header, header + sizeof(header), magic);
+    }
+
+    std::size_t save_native(const Rope& rope, const std::string& path) {
+        Writer writer(path);
+        for (const auto& leaf : rope.root()->leaves()) writer.add(*leaf);
+        return writer.finish();
+    }
+
+    Rope load_native(const std::string& path) {
+        auto styles = std::make_shared< Styles >();
+        styles->file = MappedFile::open(path);
+        const MappedFile& file = *styles->file;
+
+        Reader in(file, path);
+        if (file.size() < headerSize + trailerSize || !in.has_magic() ||
+            in.get< std::uint32_t >() != version) {
+            in.fail();
+        }
+
+        in.seek(file.size() - trailerSize);
+        std::uint64_t runsOffset = in.get< std::uint64_t >();
+        std::uint64_t tablesOffset = in.get< std::uint64_t >();
+        if (!in.has_magic() || runsOffset < headerSize ||
+            runsOffset > tablesOffset ||
+            (tablesOffset - runsOffset) % runSize != 0) {
+            in.fail();
+        }
+        styles->runsOffset = runsOffset;
+        styles->runCount = (tablesOffset - runsOffset) / runSize;
+
+        in.seek(tablesOffset);
+        std::size_t tables =
+            StyleTable::read(file.data() + tablesOffset,
+                             file.size() - tablesOffset, styles->styles);
+        if (!tables) in.fail();
+        in.seek(tablesOffset + tables);
+
+        std::uint64_t chunkCount = in.get< std::uint64_t >();
+        if (chunkCount > (file.size() - in.position()) / chunkSize) in.fail();
+
+        std::vector< rope::Node::Ptr > leaves;
+        leaves.reserve(chunkCount);
+
+        for (std::uint64_t i = 0; i < chunkCount; ++i) {
+            Chunk chunk{};
+            chunk.textOffset = in.get< std::uint64_t >();
+            chunk.bytes = in.get< std::uint32_t >();
+            chunk.length = in.get< std::uint32_t >();
+            chunk.lines = in.get< std::uint32_t >();
+            chunk.words = in.get< std::uint32_t >();
+            chunk.firstRun = in.get< std::uint32_t >();
+            chunk.runs = in.get< std::uint32_t >();
+
+            // every character takes at least one byte and every word a
+            // character with a space or line feed before it, a chunk whose
+            // text turns out not to match shows as replacement characters
+            // summed, a huge offset would wrap around past the check
+            if (chunk.textOffset < headerSize || chunk.bytes > runsOffset ||
+                chunk.textOffset > runsOffset - chunk.bytes ||
+                chunk.length > chunk.bytes ||
+                std::uint64_t{chunk.words} +
+                        std::max(chunk.lines, chunk.words) >
+                    chunk.length ||
+                std::uint64_t{chunk.firstRun} + chunk.runs >
+                    styles->runCount) {
+                in.fail();
+            }
+
+            // the leaf keeps the mapping alive, its styler the styles
+            std::shared_ptr< const char > bytes(
+                styles->file, file.data() + chunk.textOffset);
+            rope::MappedLeaf::Metrics metrics{chunk.length, chunk.lines,
+                                              chunk.words};
+            leaves.push_back(std::make_shared< rope::MappedLeaf >(
+                std::move(bytes), chunk.bytes, metrics,
+                ChunkStyler{styles, chunk.firstRun, chunk.runs}));
+        }
+
+        // like a text file, a document always ends with a newline
+        if (leaves.empty()) return Rope(nstring("\n"));
+        return Rope::from_leaves(leaves);
+    }
+
+}  // namespace io
@@ -0,0 +1,53 @@
+#ifndef IO_NATIVE_FILE_HPP
+#define IO_NATIVE_FILE_HPP
+
+#include <string>
+
+#include "rope/rope.hpp"
+
+namespace io {
+
+    /**
+     * @brief The native document format, which keeps every character
+     * attribute a text file loses.
+     * @details The text is stored once as UTF-8 and the attributes as runs
+     * of identical styles, each style written once in a table together with
+     * the links and font ids it refers to. Every rope leaf becomes one chunk
+     * of text and runs, with its metrics in the chunk index, so the reader
+     * maps the file and builds a MappedLeaf per chunk without decoding
+     * anything. A chunk is decoded and styled when it is read.
+     *
+     * Layout, integers in native byte order:
+     *   header   "NDOC", u32 version
+     *   text     the UTF-8 of every chunk, back to back
+     *   runs     u32 length, u32 style; runs never cross a chunk
+     *   tables   a StyleTable of every style the runs use
+     *   index    u64 count, chunks as u64 text offset, u32 bytes, u32 length,
+     *            u32 lines, u32 words, u32 first run, u32 runs
+     *   trailer  u64 runs offset, u64 tables offset, "NDOC"
+     */
+
+    // The file starts like a native document
+    bool is_native(const std::string& path);
+
+    /**
+     * @brief Write a rope in the native format, atomically, streaming it
+     * leaf by leaf.
+     * @return The number of bytes written.
+     * @throw std::runtime_error if the file cannot be written.
+     */
+    std::size_t save_native(const Rope& rope, const std::string& path);
+
+    /**
+     * @brief Map a native document and build its rope over the chunks.
+     * @details Chunks are only read when their text is, a chunk whose text
+     * does not match its metrics reads as replacement characters then
+     * (see rope::MappedLeaf).
+     * @throw std::runtime_error if the file cannot be mapped or is not a
+     * valid native document.
+     */
+    Rope load_native(const std::string& path);
+
+}  // namespace io
+
+#endif  // IO_NATIVE_FILE_HPP
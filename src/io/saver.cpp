@@ -0,0 +1,92 @@
+#include "io/saver.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "io/native_file.hpp"
+#include "io/text_file.hpp"
+
+namespace io {
+
+    bool Saver::Result::ok() const { return error.empty(); }
+
+    Saver::Saver() {}
+
+    Saver::~Saver() {
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+        }
+        mWake.notify_one();
+
+        if (mWorker.joinable()) mWorker.join();
+    }
+
+    void Saver::save(const Rope& snapshot, const std::string& path,
+                     Format format) {
+        {
+            std::lock_guard lock(mMutex);
+
+            auto waiting = std::find_if(
+                mJobs.begin(), mJobs.end(),
+                [&](const Job& job) { return job.path == path; });
+            if (waiting != mJobs.end()) {
+                waiting->rope = snapshot;
+                waiting->format = format;
+            } else {
+                mJobs.push_back({path, snapshot, format});
+            }
+
+            if (!mWorker.joinable()) mWorker = std::thread(&Saver::run, this);
+        }
+        mWake.notify_one();
+    }
+
+    std::optional< Saver::Result > Saver::poll() {
+        std::unique_lock lock(mMutex, std::try_to_lock);
+        if (!lock.owns_lock() || mResults.empty()) return std::nullopt;
+
+        Result result = std::move(mResults.front());
+        mResults.pop_front();
+        return result;
+    }
+
+    bool Saver::busy() const {
+        std::lock_guard lock(mMutex);
+        return mWriting || !mJobs.empty();
+    }
+
+    void Saver::wait_idle() {
+        std::unique_lock lock(mMutex);
+        mIdle.wait(lock, [&]() { return !mWriting && mJobs.empty(); });
+    }
+
+    void Saver::run() {
+        std::unique_lock lock(mMutex);
+
+        while (true) {
+            mWake.wait(lock, [&]() { return mStopping || !mJobs.empty(); });
+            if (mJobs.empty()) return;
+
+            Job job = std::move(mJobs.front());
+            mJobs.pop_front();
+            mWriting = true;
+            lock.unlock();
+
+            Result result{job.path, job.rope};
+            try {
+                result.bytes = job.format == Format::Native
+                                   ? save_native(job.rope, job.path)
+                                   : save_text(job.rope, job.path);
+            } catch (const std::runtime_error& error) {
+                result.error = error.what();
+            }
+
+            lock.lock();
+            mResults.push_back(std::move(result));
+            mWriting = false;
+            if (mJobs.empty()) mIdle.notify_all();
+        }
+    }
+
+}  // namespace io
@@ -0,0 +1,81 @@
+#ifndef IO_SAVER_HPP
+#define IO_SAVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "rope/rope.hpp"
+
+namespace io {
+
+    enum class Format { Text, Native };
+
+    /**
+     * @brief Saves rope snapshots to files on a writer thread.
+     * @details save() only queues the snapshot, which is immutable and shares
+     * its nodes with the document, so the caller can keep editing right away.
+     * The worker streams it with save_text() or save_native(). A save to a
+     * path that is still waiting in the queue replaces the waiting one, the
+     * older content would be overwritten anyway. Finished saves are picked up
+     * with poll(), which never blocks. Saves still queued when the saver is
+     * destroyed are written before the destructor returns.
+     */
+    class Saver {
+    public:
+        struct Result {
+            std::string path{};
+            // the snapshot that was written, or failed to be
+            Rope rope{};
+            std::size_t bytes{};
+            // empty on success
+            std::string error{};
+
+            bool ok() const;
+        };
+
+        Saver();
+        ~Saver();
+
+        Saver(const Saver&) = delete;
+        Saver& operator=(const Saver&) = delete;
+
+        void save(const Rope& snapshot, const std::string& path,
+                  Format format = Format::Text);
+
+        // The oldest finished save not polled yet, without blocking
+        std::optional< Result > poll();
+
+        // A save is queued or being written
+        bool busy() const;
+
+        void wait_idle();
+
+    private:
+        struct Job {
+            std::string path;
+            Rope rope;
+            Format format;
+        };
+
+        void run();
+
+        mutable std::mutex mMutex{};
+        std::condition_variable mWake{};
+        std::condition_variable mIdle{};
+
+        std::deque< Job > mJobs{};
+        bool mWriting{false};
+        bool mStopping{false};
+
+        std::deque< Result > mResults{};
+
+        std::thread mWorker{};
+    };
+
+}  // namespace io
+
+#endif  // IO_SAVER_HPP
@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "io/atomic_file.hpp"
+#include "io/journal.hpp"
+#include "io/mapped_text.hpp"
+#include "io/native_file.hpp"
+#include "io/saver.hpp"
+#include "io/text_file.hpp"
+#include "rope/builder.hpp"
+
+void write_file(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+void testDecoding() {
+    std::string path = "io_test_small.txt";
+
+    // "é" split across the first block boundary, CRLF, a lone CR and an
+    // invalid byte
+    std::string content(io::blockSize - 1, 'a');
+    content += "\xC3\xA9\r\nline\rnext\xFF!";
+    write_file(path, content);
+
+    Rope rope = io::load_text(path);
+    std::cout << "Length:     " << rope.length() << std::endl;
+    std::cout << "Split char: " << rope[io::blockSize - 1].codepoint()
+              << std::endl;
+    std::cout << "Lines:      " << rope.line_count() << std::endl;
+    std::cout << "Tail:       " << rope.substr(io::blockSize + 1, 14);
+    std::cout << "Balanced:   " << rope.is_balanced() << std::endl;
+
+    std::remove(path.c_str());
+}
+
+void testMissing() {
+    try {
+        io::load_text("io_test_missing.txt");
+        std::cout << "Missing:    no error" << std::endl;
+    } catch (const std::runtime_error& error) {
+        std::cout << "Missing:    " << error.what() << std::endl;
+    }
+}
+
+void testThroughput() {
+    std::string path = "io_test_large.txt";
+
+    std::string line = "The quick brown fox jumps over the lazy dog.\n";
+    std::string content;
+    while (content.size() < (8 << 20)) content += line;
+    write_file(path, content);
+
+    auto start = std::chrono::steady_clock::now();
+    Rope rope = io::load_text(path);
+    double seconds = std::chrono::duration< double >(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::cout << "Loaded:     " << rope.length() << " chars, "
+              << rope.line_count() << " lines" << std::endl;
+    std::cout << "Throughput: " << content.size() / seconds / (1 << 20)
+              << " MiB/s" << std::endl;
+
+    std::remove(path.c_str());
+}
+
+void testMapped() {
+    std::string path = "io_test_mapped.txt";
+
+    // several chunks, with multibyte characters and CRLF around the cuts
+    std::string line = "x\xC3\xA9\xE2\x82\xAC y\r\n";
+    std::string content;
+    while (content.size() < 5 * io::MappedText::chunkSize) content += line;
+    content += "no newline";
+    write_file(path, content);
+
+    auto start = std::chrono::steady_clock::now();
+    io::MappedText mapped(path);
+    double openMs = std::chrono::duration< double, std::milli >(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    std::cout << "Preview:    " << mapped.preview().length() << " chars"
+              << std::endl;
+    std::cout << "Open < 50ms: " << (openMs < 50) << std::endl;
+
+    std::optional< Rope > rope;
+    while (!(rope = mapped.take_result())) {
+        std::this_thread::yield();
+    }
+
+    // an edit in the middle only decodes the leaf it touches, the others
+    // stay mapped
+    Rope edited = rope->insert(rope->length() / 2, "EDIT");
+    std::size_t mappedLeaves = 0, decoded = 0;
+    for (const auto& leaf : edited.root()->leaves()) {
+        auto mappedLeaf = dynamic_cast< const rope::MappedLeaf* >(leaf.get());
+        if (!mappedLeaf) continue;
+        ++mappedLeaves;
+        if (mappedLeaf->is_decoded()) ++decoded;
+    }
+    std::cout << "Mapped:     " << mappedLeaves << " leaves, " << decoded
+              << " decoded" << std::endl;
+
+    Rope loaded = io::load_text(path);
+    auto progress = mapped.progress();
+    std::cout << "Indexed:    " << progress.bytes << "/" << progress.totalBytes
+              << " bytes, " << progress.lines << " lines" << std::endl;
+    std::cout << "Same text:  " << (rope->to_string() == loaded.to_string())
+              << std::endl;
+    std::cout << "Same lines: " << (rope->line_count() == loaded.line_count())
+              << std::endl;
+
+    // word counts depend on where leaves are cut, so compare each mapped
+    // leaf against a leaf decoded from the same bytes instead
+    bool sameMetrics = true;
+    for (const auto& leaf : rope->root()->leaves()) {
+        rope::Leaf decoded(leaf->to_nstring());
+        sameMetrics = sameMetrics && decoded.length() == leaf->length() &&
+                      decoded.line_count() == leaf->line_count() &&
+                      decoded.tail_length() == leaf->tail_length() &&
+                      decoded.word_count() == leaf->word_count();
+    }
+    std::cout << "Metrics:    " << sameMetrics << std::endl;
+
+    // reading through more text than the cache holds keeps it bounded
+    std::size_t count = 3 * rope::MappedLeaf::cacheBytes / sizeof(nchar);
+    auto bytes = std::make_shared< std::string >(count >> 16 << 16, 'x');
+    std::vector< rope::Node::Ptr > leaves;
+    for (std::size_t at = 0; at < bytes->size(); at += 1 << 16) {
+        std::shared_ptr< const char > data(bytes, bytes->data() + at);
+        leaves.push_back(std::make_shared< rope::MappedLeaf >(
+            data, 1 << 16, rope::MappedLeaf::measure(data.get(), 1 << 16)));
+    }
+    Rope large = Rope::from_leaves(leaves);
+
+    std::size_t read = 0;
+    large.for_each_chunk([&](const nstring& chunk) { read += chunk.length(); });
+    auto first = static_cast< const rope::MappedLeaf* >(leaves.front().get());
+    auto last = static_cast< const rope::MappedLeaf* >(leaves.back().get());
+    std::cout << "Cache:      " << (read == bytes->size()) << " "
+              << (rope::MappedLeaf::cached_bytes() <=
+                  rope::MappedLeaf::cacheBytes)
+              << " " << !first->is_decoded() << " " << last->is_decoded()
+              << std::endl;
+
+    std::remove(path.c_str());
+}
+
+void testSave() {
+    std::string path = "io_test_save.txt";
+    write_file(path, "old content\n");
+
+    // the writer encodes straight from the leaves
+    nstring text("h\xC3\xA9llo\n");
+    Rope rope = Rope(text);
+    for (int i = 0; i < 5000; ++i) rope = rope.append(text);
+
+    io::Saver saver;
+    saver.save(rope, path);
+
+    // keep editing while it writes, the snapshot is not affected
+    Rope edited = rope.insert(0, nstring("edit "));
+    saver.save(edited, path + ".copy");
+    saver.wait_idle();
+
+    std::size_t results = 0;
+    bool ok = true;
+    while (auto result = saver.poll()) {
+        ++results;
+        ok = ok && result->ok();
+    }
+    std::cout << "Saves:      " << results << " ok " << ok << std::endl;
+
+    Rope loaded = io::load_text(path);
+    std::cout << "Round trip: " << (loaded.to_string() == rope.to_string())
+              << std::endl;
+    std::cout << "Copy:       "
+              << (io::load_text(path + ".copy").to_string() ==
+                  edited.to_string())
+              << std::endl;
+
+    // a save that fails leaves the previous file alone
+    saver.save(edited, "io_test_missing_dir/file.txt");
+    saver.wait_idle();
+    auto failed = saver.poll();
+    std::cout << "Failed:     " << (failed && !failed->ok()) << std::endl;
+
+    try {
+        io::AtomicFile file(path);
+        file.write("partial");
+        throw std::runtime_error("interrupted");
+    } catch (const std::runtime_error&) {
+    }
+    std::cout << "Untouched:  "
+              << (io::load_text(path).to_string() == rope.to_string())
+              << std::endl;
+
+    std::remove(path.c_str());
+    std::remove((path + ".copy").c_str());
+}
+
+bool same_attributes(const nstring& a, const nstring& b) {
+    if (a.length() != b.length()) return false;
+    for (std::size_t i = 0; i < a.length(); ++i) {
+        const nchar& x = a[i];
+        const nchar& y = b[i];
+        if (x != y || x.getFontSize() != y.getFontSize() ||
+            x.getFontId() != y.getFontId() || x.getLink() != y.getLink() ||
+            x.getColor().r != y.getColor().r ||
+            x.getBackgroundColor().g != y.getBackgroundColor().g) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testNative() {
+    std::string path = "io_test_native.ndoc";
+
+    // a styled page, every attribute changing now and then
+    const int letters[] = {'h', 'e', 'l', 'l', 'o', ' ', 0xE9, 't', 0xE9, ' '};
+    nstring page;
+    for (int i = 0; i < 4096; ++i) {
+        nchar c(i % 61 == 60 ? '\n' : letters[i % 10]);
+        if (i % 70 < 30) c.toggleBold();
+        if (i % 130 < 20) c.toggleItalic();
+        if (i % 300 < 40) c.setLink("https://example.com/" +
+                                    std::to_string(i / 300 % 3));
+        if (i % 500 < 100) c.setColor(Color{200, 0, 0, 255});
+        if (i % 900 < 50) c.setBackgroundColor(Color{0, 255, 0, 255});
+        c.setFontSize(20 + i / 1000);
+        c.setFontId(i / 2048);
+        if (i == 4095) c = nchar('\n');
+        page += c;
+    }
+
+    Rope small(page);
+    io::save_native(small, path);
+    Rope loaded = io::load_native(path);
+    std::cout << "Native:     " << io::is_native(path) << " "
+              << same_attributes(loaded.to_nstring(), page) << " "
+              << (loaded.line_count() == small.line_count()) << std::endl;
+
+    // a chunk claiming a line more than its text has
+    {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+        file.seekg(-20 - 32 + 16, std::ios::end);
+        std::uint32_t lines{};
+        file.read(reinterpret_cast< char* >(&lines), sizeof(lines));
+        ++lines;
+        file.seekp(-20 - 32 + 16, std::ios::end);
+        file.write(reinterpret_cast< const char* >(&lines), sizeof(lines));
+    }
+    // shown as replacement characters, in the shape the rope expects
+    Rope corrupt = io::load_native(path);
+    std::string shown = corrupt.to_string();
+    std::cout << "Corrupt:    "
+              << (shown.find("\xEF\xBF\xBD") != std::string::npos) << " "
+              << (corrupt.to_nstring().length() == corrupt.length()) << " "
+              << (corrupt.line_count() == small.line_count() + 1)
+              << std::endl;
+
+    // a text offset so large that adding the size wraps around
+    io::save_native(small, path);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+        std::uint64_t offset = ~std::uint64_t{0} - 8;
+        file.seekp(-20 - 32, std::ios::end);
+        file.write(reinterpret_cast< const char* >(&offset), sizeof(offset));
+    }
+    bool rejected = false;
+    try {
+        io::load_native(path).to_string();
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    std::cout << "Wrapped:    " << rejected << std::endl;
+
+    // "\r\n" is read back as one line feed, the styles after it in place
+    nstring returns("a\r\nb\rc\n");
+    returns[5].toggleBold();
+    io::save_native(Rope(returns), path);
+    nstring reread = io::load_native(path).to_nstring();
+    std::cout << "Returns:    " << (reread.to_string() == "a\nb\nc\n") << " "
+              << reread[4].isBold() << std::endl;
+
+    // 10 MB of it, sharing the page leaves
+    rope::Builder builder;
+    for (int i = 0; i < 256; ++i) builder.append(page);
+    Rope block = builder.build();
+    Rope large = block;
+    while (large.length() < (10 << 20)) large = large.append(block);
+
+    auto milliseconds = [](auto start, auto end) {
+        return std::chrono::duration< double, std::milli >(end - start)
+            .count();
+    };
+
+    // encoding from nchars
+    auto start = std::chrono::steady_clock::now();
+    std::size_t bytes = io::save_native(large, path);
+    auto saved = std::chrono::steady_clock::now();
+    std::cout << "Encode ms:  " << milliseconds(start, saved) << std::endl;
+
+    // load and save again, the chunks are copied as they are
+    std::string copy = path + ".copy";
+    start = std::chrono::steady_clock::now();
+    Rope reloaded = io::load_native(path);
+    io::save_native(reloaded, copy);
+    Rope copied = io::load_native(copy);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Round ms:   " << milliseconds(start, end) << std::endl;
+
+    auto sameEnds = [&](const Rope& rope) {
+        std::size_t length = rope.length();
+        return length == large.length() &&
+               same_attributes(rope.subnstr(0, 5000),
+                               large.subnstr(0, 5000)) &&
+               same_attributes(rope.subnstr(length - 5000, 5000),
+                               large.subnstr(length - 5000, 5000));
+    };
+    std::cout << "Large:      " << bytes / (1 << 20) << " MiB, same ends "
+              << sameEnds(reloaded) << " " << sameEnds(copied) << std::endl;
+
+    // as text, restyled, the mapped chunks are still copied as bytes
+    std::string text = path + ".txt";
+    Rope restyled = copied.restyle(0, copied.length(),
+                                   StylePatch::type(nchar::Bold, true));
+    auto decoded = [&]() {
+        std::size_t count = 0;
+        for (const auto& leaf : copied.root()->leaves()) {
+            auto mapped =
+                dynamic_cast< const rope::MappedLeaf* >(leaf.get());
+            if (mapped && mapped->is_decoded()) ++count;
+        }
+        return count;
+    };
+    std::size_t before = decoded();
+    start = std::chrono::steady_clock::now();
+    io::save_text(restyled, text);
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "As text:    " << decoded() - before << " decoded, same "
+              << (io::load_text(text).subnstr(0, 5000).to_string() ==
+                  large.subnstr(0, 5000).to_string())
+              << std::endl;
+    std::cout << "Text ms:    " << milliseconds(start, end) << std::endl;
+
+    std::remove(path.c_str());
+    std::remove(copy.c_str());
+    std::remove(text.c_str());
+}
+
+void testClipboard() {
+    std::string line = "copy \xC3\xA9 paste\r\n";
+    std::string small, large;
+    while (small.size() < (1 << 20)) small += line;
+    while (large.size() < (10 << 20)) large += line;
+
+    auto seconds = [](const std::string& text) {
+        auto start = std::chrono::steady_clock::now();
+        Rope rope = io::decode_text(text.data(), text.size());
+        std::string encoded = io::encode_text(rope);
+        return std::chrono::duration< double >(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    };
+
+    Rope rope = io::decode_text(large.data(), large.size());
+    std::string lf = line.substr(0, line.size() - 2) + "\n";
+    std::cout << "Clipboard:  " << rope.is_balanced() << " "
+              << (io::encode_text(rope.subrope(0, 3 * 13)) == lf + lf + lf)
+              << std::endl;
+
+    // ten times the text, about ten times the time
+    double ratio = seconds(large) / seconds(small);
+    std::cout << "Linear:     " << (ratio > 5 && ratio < 20) << std::endl;
+}
+
+void testJournal() {
+    std::string path = "io_test.journal";
+    using history::Edit;
+    using history::EditKind;
+
+    Rope base(nstring("journal base\n"));
+    Rope expected = base;
+
+    double worstUs = 0, totalUs = 0;
+    std::size_t edits = 2 * io::Journal::compactInterval + 100;
+    {
+        io::Journal journal(path, base);
+
+        for (std::size_t i = 0; i < edits; ++i) {
+            Edit edit{EditKind::Typing, i % 7, nstring(),
+                      nstring(std::string(1, 'a' + i % 26))};
+            if (i % 100 == 99) {
+                // a style change
+                nstring styled = expected.subnstr(0, 5);
+                styled.toggleBold(0, 5);
+                edit = Edit{EditKind::Style, 0, expected.subnstr(0, 5),
+                            styled};
+            } else if (i % 100 == 49) {
+                // typing at several cursors
+                edit = history::combine(expected, {{1, 1, nstring("MM")},
+                                                   {4, 0, nstring("N")},
+                                                   {6, 2, Rope()}});
+            }
+            expected = history::apply(expected, edit);
+
+            auto start = std::chrono::steady_clock::now();
+            journal.append(edit);
+            double us = std::chrono::duration< double, std::micro >(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+            totalUs += us;
+            worstUs = std::max(worstUs, us);
+        }
+
+        journal.wait_idle();
+        std::cout << "Journaled:  " << journal.committed() << " edits, "
+                  << journal.compactions() << " snapshots, error '"
+                  << journal.error() << "'" << std::endl;
+        // the journal is left behind, as after a crash
+    }
+    std::cout << "Append us:  " << (totalUs / edits < 50) << std::endl;
+
+    auto recovered = io::Journal::recover(path);
+    std::cout << "Recovered:  "
+              << (recovered && same_attributes(recovered->to_nstring(),
+                                               expected.to_nstring()))
+              << std::endl;
+
+    // a record torn by the crash is ignored
+    {
+        std::ofstream journal(path, std::ios::binary | std::ios::app);
+        journal << "\x40\0\0\0torn";
+    }
+    recovered = io::Journal::recover(path);
+    std::cout << "Torn tail:  "
+              << (recovered && recovered->to_string() == expected.to_string())
+              << std::endl;
+
+    // starting over continues from the recovered state, then saving
+    // discards it
+    io::Journal journal(path, *recovered);
+    journal.append({EditKind::Typing, 0, nstring(), nstring("x")});
+    journal.wait_idle();
+    std::cout << "Continued:  "
+              << (io::Journal::recover(path)->to_string() ==
+                  "x" + expected.to_string())
+              << std::endl;
+
+    journal.discard();
+    std::cout << "Discarded:  " << !io::Journal::recover(path) << " "
+              << !std::ifstream(path) << std::endl;
+
+    // a journal left behind whose recovery was declined
+    {
+        io::Journal left(path, base);
+        left.wait_idle();
+    }
+    io::Journal::remove(path);
+    std::cout << "Removed:    " << !std::ifstream(path) << " "
+              << !std::ifstream(path + ".1") << std::endl;
+}
+
+void testJournalError() {
+    using history::EditKind;
+
+    // the directory is missing until the journal is started over
+    std::string directory = "io_test_journal";
+    std::filesystem::remove_all(directory);
+    std::string path = directory + "/doc.journal";
+
+    Rope base(nstring("base\n"));
+    io::Journal journal(path, base);
+    journal.append({EditKind::Typing, 0, nstring(), nstring("a")});
+    journal.wait_idle();
+    std::cout << "Failed:     " << !journal.error().empty() << " "
+              << journal.committed() << " committed" << std::endl;
+
+    std::filesystem::create_directory(directory);
+    journal.reset(Rope(nstring("ab\n")));
+    journal.append({EditKind::Typing, 2, nstring(), nstring("c")});
+    journal.wait_idle();
+    auto recovered = io::Journal::recover(path);
+    std::cout << "Restarted:  " << journal.error().empty() << " "
+              << journal.committed() << " committed "
+              << (recovered && recovered->to_string() == "abc\n")
+              << std::endl;
+
+    journal.discard();
+    std::filesystem::remove_all(directory);
+}
+
+int main() {
+    testDecoding();
+    testMissing();
+    testThroughput();
+    testMapped();
+    testSave();
+    testNative();
+    testClipboard();
+    testJournal();
+    testJournalError();
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "io/text_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "io/atomic_file.hpp"
+#include "rope/builder.hpp"
+#include "text/utf8.hpp"
+
+namespace io {
+
+    Rope load_text(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Could not open file: " + path);
+        }
+
+        rope::Builder builder;
+        utf8::TextDecoder decoder;
+
+        int last = 0;
+        auto push = [&](int codepoint) {
+            builder.append(codepoint);
+            last = codepoint;
+        };
+
+        std::vector< char > block(blockSize);
+        while (file) {
+            file.read(block.data(), block.size());
+            decoder.feed(block.data(), file.gcount(), push);
+        }
+        if (file.bad()) {
+            throw std::runtime_error("Could not read file: " + path);
+        }
+        decoder.finish(push);
+
+        if (last != '\n') builder.append('\n');
+
+        return builder.build();
+    }
+
+    Rope decode_text(const char* data, std::size_t size) {
+        rope::Builder builder;
+        utf8::TextDecoder decoder;
+
+        auto push = [&](int codepoint) { builder.append(codepoint); };
+        decoder.feed(data, size, push);
+        decoder.finish(push);
+
+        return builder.build();
+    }
+
+    std::string encode_text(const Rope& rope) {
+        // exact for ASCII, other text grows it geometrically
+        std::string text;
+        text.reserve(rope.length());
+
+        rope.for_each_chunk([&](const nstring& chunk) {
+            for (std::size_t i = 0; i < chunk.length(); ++i) {
+                utf8::append(text, chunk[i].codepoint());
+            }
+        });
+        return text;
+    }
+
+    std::size_t save_text(const Rope& rope, const std::string& path) {
+        AtomicFile file(path);
+
+        std::string block;
+        block.reserve(blockSize + 4);
+
+        auto encode = [&](const nstring& chunk) {
+            for (std::size_t i = 0; i < chunk.length(); ++i) {
+                utf8::append(block, chunk[i].codepoint());
+                if (block.size() >= blockSize) {
+                    file.write(block);
+                    block.clear();
+                }
+            }
+        };
+
+        // left to right; styles do not change the text, so styled nodes
+        // are walked through to what they wrap
+        std::vector< const rope::Node* > pending{rope.root().get()};
+        while (!pending.empty()) {
+            const rope::Node* node = pending.back();
+            pending.pop_back();
+
+            // the bytes of a mapped leaf are its text already, unless
+            // decoding would turn its "\r\n" into "\n"
+            auto mapped = dynamic_cast< const rope::MappedLeaf* >(node);
+            if (mapped && !std::memchr(mapped->raw_data(), '\r',
+                                       mapped->raw_size())) {
+                file.write(block);
+                block.clear();
+                file.write(mapped->raw_data(), mapped->raw_size());
+                continue;
+            }
+
+            auto children = node->children();
+            if (children.empty() || mapped) {
+                node->for_each_chunk(encode);
+                continue;
+            }
+            for (auto child = children.rbegin(); child != children.rend();
+                 ++child) {
+                pending.push_back(child->get());
+            }
+        }
+        file.write(block);
+
+        file.commit();
+        return file.size();
+    }
+
+}  // namespace io
@@ -0,0 +1,41 @@
+#ifndef IO_TEXT_FILE_HPP
+#define IO_TEXT_FILE_HPP
+
+#include <string>
+
+#include "rope/rope.hpp"
+
+namespace io {
+    constexpr std::size_t blockSize = 1 << 16;
+
+    /**
+     * @brief Load a UTF-8 text file into a balanced rope.
+     * @details The file is read in blocks of blockSize bytes and decoded
+     * incrementally straight into rope leaves, so memory stays at one block
+     * plus the rope itself. Line endings are normalized to '\n' and a final
+     * newline is added if the file has none, as the document expects.
+     * @throw std::runtime_error if the file cannot be read.
+     */
+    Rope load_text(const std::string& path);
+
+    /**
+     * @brief Write a rope to a text file as UTF-8, atomically.
+     * @details The rope is walked leaf by leaf and encoded into a block
+     * buffer, it is never flattened into one string. Leaves mapped from
+     * a file are copied as bytes, without decoding them. The file is replaced
+     * through an AtomicFile, so a failed or interrupted save leaves the
+     * previous content in place.
+     * @return The number of bytes written.
+     * @throw std::runtime_error if the file cannot be written.
+     */
+    std::size_t save_text(const Rope& rope, const std::string& path);
+
+    // UTF-8 text in memory (e.g. the clipboard) into a balanced rope, with
+    // line endings normalized like load_text() but no newline added
+    Rope decode_text(const char* data, std::size_t size);
+
+    // The rope as UTF-8, encoded leaf by leaf into one buffer
+    std::string encode_text(const Rope& rope);
+}  // namespace io
+
+#endif  // IO_TEXT_FILE_HPP
@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include "profile/profiler.hpp"
+
 int modify_key(int key) {
     switch (key) {
         case KEY_LEFT_SHIFT:
@@ -44,6 +46,8 @@ void Keybind::insert(const std::vector< int >& keys,
 }
 
 void Keybind::process(bool editable) {
+    PROFILE_SCOPE("Keybind::process");
+
     int key = GetKeyPressed();
 
     if (key == KEY_NULL) {
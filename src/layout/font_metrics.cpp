@@ -0,0 +1,33 @@
+#include "layout/font_metrics.hpp"
+
+using layout::FontMetrics;
+
+FontMetrics::FontMetrics(const DocumentFont* fonts) : mFonts{fonts} {}
+
+const Font& FontMetrics::font(const nchar& c) const {
+    if (c.isBold() && c.isItalic()) {
+        return mFonts->get_bold_italic_font(c.getFontId());
+    } else if (c.isBold()) {
+        return mFonts->get_bold_font(c.getFontId());
+    } else if (c.isItalic()) {
+        return mFonts->get_italic_font(c.getFontId());
+    }
+    return mFonts->get_font(c.getFontId());
+}
+
+float FontMetrics::advance(const nchar& c, float fontSize) const {
+    const Font& charFont = font(c);
+    int index = GetGlyphIndex(charFont, c.codepoint());
+    float scaleFactor = fontSize / charFont.baseSize;
+
+    return charFont.glyphs[index].advanceX == 0
+               ? charFont.recs[index].width * scaleFactor
+               : charFont.glyphs[index].advanceX * scaleFactor;
+}
+
+float FontMetrics::line_height(const nchar& c, float fontSize) const {
+    const Font& charFont = font(c);
+    float scaleFactor = fontSize / charFont.baseSize;
+
+    return (charFont.baseSize + charFont.baseSize / 2) * scaleFactor;
+}
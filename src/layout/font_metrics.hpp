@@ -0,0 +1,26 @@
+#ifndef LAYOUT_FONT_METRICS_HPP
+#define LAYOUT_FONT_METRICS_HPP
+
+#include "DocumentFont.hpp"
+#include "layout/glyph_metrics.hpp"
+#include "raylib.h"
+
+namespace layout {
+    // Metrics of the raylib fonts registered in a DocumentFont, the same
+    // glyphs the editor draws
+    class FontMetrics : public GlyphMetrics {
+    public:
+        explicit FontMetrics(const DocumentFont* fonts);
+
+        // The font c is drawn with, by its font id, bold and italic
+        const Font& font(const nchar& c) const;
+
+        float advance(const nchar& c, float fontSize) const override;
+        float line_height(const nchar& c, float fontSize) const override;
+
+    private:
+        const DocumentFont* mFonts{};
+    };
+}  // namespace layout
+
+#endif  // LAYOUT_FONT_METRICS_HPP
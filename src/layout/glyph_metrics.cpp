@@ -0,0 +1,14 @@
+#include "layout/glyph_metrics.hpp"
+
+using layout::FixedMetrics;
+
+FixedMetrics::FixedMetrics(float width, float lineHeight)
+    : mWidth{width}, mLineHeight{lineHeight} {}
+
+float FixedMetrics::advance(const nchar&, float fontSize) const {
+    return mWidth * fontSize;
+}
+
+float FixedMetrics::line_height(const nchar&, float fontSize) const {
+    return mLineHeight * fontSize;
+}
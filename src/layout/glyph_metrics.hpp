@@ -0,0 +1,36 @@
+#ifndef LAYOUT_GLYPH_METRICS_HPP
+#define LAYOUT_GLYPH_METRICS_HPP
+
+#include "text/nchar.hpp"
+
+namespace layout {
+    // What the layout needs to know about the glyphs of the fonts. Only the
+    // style and codepoint of a character are used, so an implementation
+    // does not need a window or loaded textures. Implementations are read
+    // from several threads at once.
+    class GlyphMetrics {
+    public:
+        virtual ~GlyphMetrics() = default;
+
+        // How far the pen moves past c drawn at fontSize
+        virtual float advance(const nchar& c, float fontSize) const = 0;
+        // Distance between the tops of two lines of c drawn at fontSize
+        virtual float line_height(const nchar& c, float fontSize) const = 0;
+    };
+
+    // Every glyph as wide as a fixed part of its font size, for layout
+    // without any font, as in benchmarks and tests
+    class FixedMetrics : public GlyphMetrics {
+    public:
+        explicit FixedMetrics(float width = 0.5f, float lineHeight = 1.5f);
+
+        float advance(const nchar& c, float fontSize) const override;
+        float line_height(const nchar& c, float fontSize) const override;
+
+    private:
+        float mWidth{};
+        float mLineHeight{};
+    };
+}  // namespace layout
+
+#endif  // LAYOUT_GLYPH_METRICS_HPP
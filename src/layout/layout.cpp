@@ -0,0 +1,243 @@
+#include "layout/layout.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <optional>
+#include <thread>
+
+using layout::GlyphMetrics;
+using layout::Positions;
+
+namespace {
+    // paragraphs are batched up to about this many characters
+    constexpr std::size_t batchLength = 1 << 14;
+
+    // Lays characters out from the top of the page as they are added,
+    // appending their positions. Only the line being measured is kept, so
+    // content can come in pieces, such as the leaves of a rope.
+    class Placer {
+    public:
+        Placer(const GlyphMetrics& metrics, Vector2 page, Positions& positions)
+            : mMetrics{metrics}, mPage{page}, mPositions{positions} {}
+
+        // Returns false once a character did not fit, the ones after it
+        // are not placed
+        bool add(const nchar& c) {
+            int fontSize = c.getFontSize();
+            if (c.isSuperscript() || c.isSubscript()) fontSize /= 2;
+
+            int codepoint = c.codepoint();
+            float advance = 0;
+            if (codepoint != '\n') advance = mMetrics.advance(c, fontSize);
+
+            mGlyphs.push_back({codepoint, fontSize,
+                               mMetrics.line_height(c, fontSize), advance});
+            return run();
+        }
+
+        // Places the last line, returns the height the content took or
+        // nothing if it did not fit
+        std::optional< float > finish() {
+            // the content ends the line being measured
+            int length = mFirst + mGlyphs.size();
+            if (!mFailed && mMeasuring && mStartLine + 1 < length) {
+                mEndLine = length - 1;
+                start_walk();
+            }
+
+            if (!run()) return std::nullopt;
+            return mOffsetY;
+        }
+
+    private:
+        struct Glyph {
+            int codepoint;
+            int fontSize;
+            float lineHeight;
+            float advance;
+        };
+
+        const Glyph& glyph(int i) const { return mGlyphs[i - mFirst]; }
+
+        // every line is measured first to find where it breaks, then walked
+        // again to place its characters
+        bool run() {
+            if (mFailed) return false;
+
+            int length = mFirst + mGlyphs.size();
+            while (mNext < length) {
+                int i = mNext++;
+                const Glyph& g = glyph(i);
+                int codepoint = g.codepoint;
+
+                mLineHeight = std::max(mLineHeight, g.lineHeight);
+                float glyphWidth = g.advance;
+
+                if (mMeasuring) {
+                    if (codepoint == ' ' || codepoint == '\t' ||
+                        codepoint == '\n') {
+                        mEndLine = i;
+                    }
+
+                    bool lineEnds = true;
+                    if (mOffsetX + glyphWidth > mPage.x) {
+                        // a word longer than the line breaks where it
+                        // overflows
+                        mEndLine = mEndLine < 1 ? i : mEndLine;
+                        if (i == mEndLine) mEndLine -= 1;
+                        if (mStartLine + 1 == mEndLine) mEndLine = i - 1;
+                    } else if (codepoint != '\n') {
+                        // the line goes on, the last one ends in finish()
+                        lineEnds = false;
+                    }
+
+                    if (lineEnds) {
+                        start_walk();
+                        continue;
+                    }
+                } else {
+                    if (codepoint != '\n' &&
+                        mOffsetY + g.fontSize > mPage.y) {
+                        mFailed = true;
+                        return false;
+                    }
+                    mPositions.push_back({mOffsetX, mOffsetY});
+
+                    if (i == mEndLine) {
+                        mPositions.end_line(mLineHeight);
+                        mOffsetY += mLineHeight;
+                        mOffsetX = 0;
+                        mStartLine = mEndLine;
+                        mEndLine = -1;
+                        glyphWidth = 0;
+                        mLineHeight = 0.0f;
+
+                        mMeasuring = true;
+                        forget(i + 1);
+                    }
+                }
+
+                // avoid leading spaces
+                if (mOffsetX != 0 || codepoint != ' ') {
+                    mOffsetX += glyphWidth;
+                }
+            }
+
+            // a line still being walked will not come back to its start
+            if (!mMeasuring) forget(mNext);
+            return true;
+        }
+
+        // goes back to the start of the measured line to place it
+        void start_walk() {
+            mMeasuring = false;
+            mOffsetX = 0;
+            mNext = mStartLine + 1;
+        }
+
+        // drops the glyphs before `index`, once they are at least as many
+        // as those left so that moving them costs a constant a glyph
+        void forget(int index) {
+            std::size_t count = index - mFirst;
+            if (count < mGlyphs.size() - count) return;
+
+            mGlyphs.erase(mGlyphs.begin(), mGlyphs.begin() + count);
+            mFirst = index;
+        }
+
+        const GlyphMetrics& mMetrics;
+        Vector2 mPage;
+        Positions& mPositions;
+
+        // glyphs from index mFirst on
+        std::vector< Glyph > mGlyphs{};
+        int mFirst{0};
+        int mNext{0};
+
+        float mOffsetX{0.0f};
+        float mOffsetY{0.0f};
+        float mLineHeight{0.0f};
+
+        bool mMeasuring{true};
+        int mStartLine{-1};  // last character before the line
+        int mEndLine{-1};    // last character of the line
+        bool mFailed{false};
+    };
+
+    // Calls body(i) for every i in [0, count) on up to `threads` threads,
+    // each taking the next index left when done with one
+    template < typename Body >
+    void parallel_for(std::size_t count, std::size_t threads, Body&& body) {
+        std::atomic< std::size_t > next{0};
+        auto work = [&] {
+            for (std::size_t i = next++; i < count; i = next++) body(i);
+        };
+
+        std::vector< std::thread > workers;
+        for (std::size_t t = 1; t < std::min(threads, count); ++t) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) worker.join();
+    }
+}  // namespace
+
+bool layout::wrap(const nstring& content, const GlyphMetrics& metrics,
+                  Vector2 page, Positions& positions) {
+    positions.clear();
+
+    Placer placer(metrics, page, positions);
+    for (std::size_t i = 0; i < content.length(); ++i) {
+        if (!placer.add(content[i])) return true;
+    }
+    return !placer.finish();
+}
+
+float layout::wrap_paragraphs(const Rope& text, const GlyphMetrics& metrics,
+                              float width, Positions& positions,
+                              std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // batches start after a line feed, where the layout starts over
+    std::size_t length = text.length();
+    std::vector< std::size_t > bounds{0};
+    while (bounds.back() < length) {
+        std::size_t target =
+            std::min(bounds.back() + batchLength, length) - 1;
+        std::size_t line = text.pos_from_index(target).first;
+        bounds.push_back(std::min(text.find_line_start(line + 1), length));
+    }
+
+    std::size_t batches = bounds.size() - 1;
+    std::vector< Positions > placed(batches);
+    std::vector< float > heights(batches);
+
+    Vector2 page = {width, std::numeric_limits< float >::infinity()};
+    parallel_for(batches, threads, [&](std::size_t batch) {
+        // the batch's leaves are shared, not flattened into a copy
+        std::size_t start = bounds[batch];
+        Rope paragraphs = text.subrope(start, bounds[batch + 1] - start);
+
+        Placer placer(metrics, page, placed[batch]);
+        paragraphs.for_each_chunk([&](const nstring& chunk) {
+            for (std::size_t i = 0; i < chunk.length(); ++i) {
+                placer.add(chunk[i]);
+            }
+        });
+        heights[batch] = *placer.finish();
+    });
+
+    // each batch moves down by the heights of those above it
+    positions.clear();
+    float top = 0.0f;
+    for (std::size_t batch = 0; batch < batches; ++batch) {
+        positions.append(placed[batch], top);
+        top += heights[batch];
+    }
+    positions.shrink_to_fit();
+
+    return top;
+}
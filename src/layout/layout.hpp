@@ -0,0 +1,32 @@
+#ifndef LAYOUT_LAYOUT_HPP
+#define LAYOUT_LAYOUT_HPP
+
+#include "layout/glyph_metrics.hpp"
+#include "layout/positions.hpp"
+#include "raylib.h"
+#include "rope/rope.hpp"
+#include "text/nstring.hpp"
+
+namespace layout {
+    // Lays content out on a page of the given size, wrapping lines at the
+    // last space, tab or line feed that fits, or inside a word longer than a
+    // line. positions gets the top left corner of every character placed,
+    // relative to the page. Returns true if the content did not fit, the
+    // characters past the page are left without a position.
+    bool wrap(const nstring& content, const GlyphMetrics& metrics,
+              Vector2 page, Positions& positions);
+
+    // Lays all of text out on a page of the given width without a height
+    // limit, for pagination and export. Lines wrap the same way in every
+    // paragraph (up to a line feed), so batches of paragraphs are laid out
+    // on up to `threads` threads, all of the hardware ones if 0, and moved
+    // down by the height of the batches above. positions are those of
+    // wrap() on a page tall enough, up to rounding. Returns the height of
+    // the text. The editor does not call it yet: it shows one page, which
+    // Document::processWordWrap lays out with wrap() alone.
+    float wrap_paragraphs(const Rope& text, const GlyphMetrics& metrics,
+                          float width, Positions& positions,
+                          std::size_t threads = 0);
+}  // namespace layout
+
+#endif  // LAYOUT_LAYOUT_HPP
@@ -0,0 +1,173 @@
+#include "layout/positions.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using layout::Positions;
+
+void Positions::clear() {
+    mLines.clear();
+    mSteps.clear();
+    mAnchors.clear();
+    mWide.clear();
+    mLastUnits = 0;
+    mLineEnded = true;
+}
+
+std::size_t Positions::size() const { return mSteps.size(); }
+
+bool Positions::empty() const { return mSteps.empty(); }
+
+std::size_t Positions::line_count() const { return mLines.size(); }
+
+std::size_t Positions::bytes() const {
+    return mLines.capacity() * sizeof(Line) + mSteps.capacity() +
+           mAnchors.capacity() * sizeof(std::uint16_t) +
+           mWide.capacity() * sizeof(mWide[0]);
+}
+
+void Positions::push_back(Vector2 position) {
+    std::size_t index = mSteps.size();
+    std::uint16_t units = to_units(position.x);
+
+    if (mLineEnded || mLines.back().y != position.y) {
+        mLines.push_back({static_cast< std::uint32_t >(index),
+                          static_cast< std::uint32_t >(mAnchors.size()),
+                          position.y, 0.0f});
+        mLineEnded = false;
+    }
+
+    if ((index - mLines.back().start) % anchorInterval == 0) {
+        mAnchors.push_back(units);
+        mSteps.push_back(0);
+    } else if (units >= mLastUnits && units - mLastUnits < wide) {
+        mSteps.push_back(units - mLastUnits);
+    } else {
+        mSteps.push_back(wide);
+        mWide.push_back({index, units});
+    }
+    mLastUnits = units;
+}
+
+void Positions::end_line(float height) {
+    if (mLines.empty()) return;
+
+    mLines.back().height = height;
+    mLineEnded = true;
+}
+
+void Positions::append(const Positions& other, float dy) {
+    auto offset = static_cast< std::uint32_t >(mSteps.size());
+    auto anchors = static_cast< std::uint32_t >(mAnchors.size());
+
+    for (Line line : other.mLines) {
+        line.start += offset;
+        line.anchor += anchors;
+        line.y += dy;
+        mLines.push_back(line);
+    }
+    mSteps.insert(mSteps.end(), other.mSteps.begin(), other.mSteps.end());
+    mAnchors.insert(mAnchors.end(), other.mAnchors.begin(),
+                    other.mAnchors.end());
+    for (auto [index, units] : other.mWide) {
+        mWide.push_back({index + offset, units});
+    }
+
+    // the next character starts a line of its own
+    mLastUnits = other.mLastUnits;
+    mLineEnded = true;
+}
+
+void Positions::shrink_to_fit() {
+    mLines.shrink_to_fit();
+    mSteps.shrink_to_fit();
+    mAnchors.shrink_to_fit();
+    mWide.shrink_to_fit();
+}
+
+Vector2 Positions::at(std::size_t index) const {
+    const Line& line = mLines[line_of(index)];
+    return {units_at(line, index) * unit, line.y};
+}
+
+float Positions::line_height(std::size_t index) const {
+    return mLines[line_of(index)].height;
+}
+
+std::size_t Positions::hit_test(Vector2 point) const {
+    if (mLines.empty()) return 0;
+
+    auto below = std::upper_bound(
+        mLines.begin(), mLines.end(), point.y,
+        [](float y, const Line& line) { return y < line.y; });
+    std::size_t lineIndex =
+        below == mLines.begin() ? 0 : below - mLines.begin() - 1;
+    const Line& line = mLines[lineIndex];
+    std::size_t end = line_end(lineIndex);
+
+    // x only grows along a line: the first anchor at or right of the point,
+    // then the steps of the block before it
+    std::size_t anchorCount =
+        (end - line.start + anchorInterval - 1) / anchorInterval;
+    auto first = mAnchors.begin() + line.anchor;
+    std::size_t block =
+        std::lower_bound(first, first + anchorCount, point.x,
+                         [](std::uint16_t units, float x) {
+                             return units * unit < x;
+                         }) -
+        first;
+    if (block == 0) return line.start;
+
+    // the edge closer to the point, of the character before it or after it
+    auto closer = [&](std::size_t index, std::uint16_t before,
+                      std::uint16_t after) {
+        return point.x - before * unit < after * unit - point.x ? index - 1
+                                                                : index;
+    };
+
+    std::size_t index = line.start + (block - 1) * anchorInterval;
+    std::size_t blockEnd = std::min(index + anchorInterval, end);
+    std::uint16_t before = first[block - 1];
+    for (++index; index < blockEnd; ++index) {
+        std::uint16_t units = step(index, before);
+        if (units * unit >= point.x) return closer(index, before, units);
+        before = units;
+    }
+
+    if (index == end) return end - 1;
+    return closer(index, before, first[block]);
+}
+
+std::uint16_t Positions::to_units(float x) {
+    return static_cast< std::uint16_t >(
+        std::clamp(std::round(x / unit), 0.0f, 65535.0f));
+}
+
+std::size_t Positions::line_of(std::size_t index) const {
+    auto after = std::upper_bound(
+        mLines.begin(), mLines.end(), index,
+        [](std::size_t i, const Line& line) { return i < line.start; });
+    return after - mLines.begin() - 1;
+}
+
+std::size_t Positions::line_end(std::size_t line) const {
+    return line + 1 < mLines.size() ? mLines[line + 1].start : mSteps.size();
+}
+
+std::uint16_t Positions::step(std::size_t index, std::uint16_t units) const {
+    if (mSteps[index] != wide) return units + mSteps[index];
+
+    auto found = std::lower_bound(
+        mWide.begin(), mWide.end(), index,
+        [](const auto& entry, std::size_t i) { return entry.first < i; });
+    return found->second;
+}
+
+std::uint16_t Positions::units_at(const Line& line, std::size_t index) const {
+    std::size_t offset = index - line.start;
+    std::size_t anchor = index - offset % anchorInterval;
+
+    std::uint16_t units = mAnchors[line.anchor + offset / anchorInterval];
+    for (std::size_t i = anchor + 1; i <= index; ++i) units = step(i, units);
+    return units;
+}
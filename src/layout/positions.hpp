@@ -0,0 +1,85 @@
+#ifndef LAYOUT_POSITIONS_HPP
+#define LAYOUT_POSITIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "raylib.h"
+
+namespace layout {
+    // Display positions of laid out text, kept by visual line: where the
+    // line starts in the text, its top and its height. The x of a character
+    // is kept in half pixels as the step from the one before it, in a byte,
+    // with the whole x of every 16th character of a line to start from. A
+    // character takes a little over a byte instead of the 8 of a Vector2.
+    class Positions {
+    public:
+        void clear();
+
+        // Characters with a position
+        std::size_t size() const;
+        bool empty() const;
+        std::size_t line_count() const;
+        // Memory held, including unused capacity
+        std::size_t bytes() const;
+
+        // Places the next character, it starts a new line after end_line()
+        // or if its y is not the one of the line
+        void push_back(Vector2 position);
+        // Ends the line of the last character, which is height tall
+        void end_line(float height);
+        // Places every character of other after these, dy lower
+        void append(const Positions& other, float dy);
+        // Gives back the capacity no character uses
+        void shrink_to_fit();
+
+        // Position of the character at index, less than size(). Takes a
+        // search of the lines and at most 16 steps.
+        Vector2 at(std::size_t index) const;
+        // Height of the line of the character at index, 0 until it ends
+        float line_height(std::size_t index) const;
+        // Index of the character a caret at point goes before: on the last
+        // line starting above point, the one whose left edge is closest to
+        // it. Above the text that is on the first line, below it on the last
+        // one, left of a line its first character and right of it its last
+        // one, the line feed or space it ends with. 0 if there is no text.
+        std::size_t hit_test(Vector2 point) const;
+
+    private:
+        // text laid out at once is far below 4G characters
+        struct Line {
+            std::uint32_t start;
+            // index in mAnchors of the x of its first character
+            std::uint32_t anchor;
+            float y;
+            float height;
+        };
+
+        static constexpr std::size_t anchorInterval = 16;
+        static constexpr float unit = 0.5f;
+        // a step too large for a byte is looked up in mWide
+        static constexpr std::uint8_t wide = 255;
+
+        static std::uint16_t to_units(float x);
+
+        std::size_t line_of(std::size_t index) const;
+        std::size_t line_end(std::size_t line) const;
+        // units of the character at index, from those of the one before it
+        std::uint16_t step(std::size_t index, std::uint16_t units) const;
+        // units of the character at index, counted from its anchor
+        std::uint16_t units_at(const Line& line, std::size_t index) const;
+
+        std::vector< Line > mLines{};
+        std::vector< std::uint8_t > mSteps{};
+        std::vector< std::uint16_t > mAnchors{};
+        // units of the characters whose step did not fit, sorted by index
+        std::vector< std::pair< std::size_t, std::uint16_t > > mWide{};
+
+        std::uint16_t mLastUnits{};
+        bool mLineEnded{true};
+    };
+}  // namespace layout
+
+#endif  // LAYOUT_POSITIONS_HPP
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "layout/layout.hpp"
+#include "rope/builder.hpp"
+
+// Glyphs half as wide as the font size, 18 at the default size of 36, and
+// lines 54 apart
+layout::FixedMetrics metrics;
+
+void print(const std::string& text, Vector2 page) {
+    layout::Positions positions;
+    bool overflow = layout::wrap(nstring(text), metrics, page, positions);
+
+    std::cout << "Input:    " << text << std::endl;
+    std::cout << "Overflow: " << overflow << "  placed " << positions.size()
+              << std::endl;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        Vector2 position = positions.at(i);
+        if (i == 0 || position.y != positions.at(i - 1).y) {
+            std::cout << (i ? "\n" : "") << "  y " << position.y << ":";
+        }
+        std::cout << " " << position.x;
+    }
+    std::cout << std::endl;
+}
+
+void testSubscript() {
+    // subscripts are laid out at half the size
+    nstring text("ab");
+    text[1].toggleSubscript();
+
+    layout::Positions positions;
+    layout::wrap(text + nstring("c"), metrics, {1000, 1000}, positions);
+    std::cout << "Subscript: " << positions.at(1).x << " "
+              << positions.at(2).x << std::endl;
+}
+
+void testParagraphs() {
+    // paragraphs of words, some of them longer than a batch
+    std::mt19937 rng(5);
+    std::string text;
+    while (text.size() < 200000) {
+        std::size_t words = rng() % 8 ? rng() % 40 : 4000;
+        for (std::size_t i = 0; i < words; ++i) {
+            text += std::string(1 + rng() % 9, 'a' + rng() % 26) + ' ';
+        }
+        text += '\n';
+    }
+    nstring content(text);
+    content[10].toggleSuperscript();
+    content[100].setFontSize(72);
+    // steps too wide for a byte
+    content[300].setFontSize(600);
+
+    rope::Builder builder;
+    builder.append(content);
+    Rope rope = builder.build();
+
+    layout::Positions expected, positions;
+    layout::wrap(content, metrics, {1100, 1e9}, expected);
+
+    for (std::size_t threads : {1, 4}) {
+        float height =
+            layout::wrap_paragraphs(rope, metrics, 1100, positions, threads);
+        bool same = positions.size() == expected.size();
+        for (std::size_t i = 0; same && i < positions.size(); ++i) {
+            same = positions.at(i).x == expected.at(i).x &&
+                   positions.at(i).y == expected.at(i).y;
+        }
+        Vector2 last = expected.at(expected.size() - 1);
+        std::cout << "Paragraphs on " << threads << ": same " << same
+                  << ", below the last line " << (height > last.y)
+                  << std::endl;
+    }
+
+    // every position leads back to the first character placed there
+    bool found = true;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        Vector2 position = positions.at(i);
+        Vector2 back = positions.at(positions.hit_test(position));
+        found &= back.x == position.x && back.y == position.y;
+    }
+    std::cout << "Found:    " << found << std::endl;
+    std::cout << "Bytes:    "
+              << double(positions.bytes()) / positions.size() << " a character"
+              << std::endl;
+}
+
+void testPositions() {
+    layout::Positions positions;
+    for (float y : {0.0f, 40.0f}) {
+        for (float x : {0.0f, 0.0f, 10.0f, 10.25f, 400.0f, 420.5f}) {
+            positions.push_back({x, y});
+        }
+        positions.end_line(40);
+    }
+    for (int i = 0; i < 40; ++i) positions.push_back({i * 20.0f, 100});
+
+    std::cout << "Lines:    " << positions.line_count() << " "
+              << positions.size() << " " << positions.line_height(3) << " "
+              << positions.line_height(20) << std::endl;
+    std::cout << "At:       ";
+    for (std::size_t i : {0, 3, 4, 5, 9, 12, 30, 45}) {
+        Vector2 position = positions.at(i);
+        std::cout << position.x << "," << position.y << " ";
+    }
+    std::cout << std::endl;
+
+    // the closest edge, on the closest line
+    std::cout << "Hit:      ";
+    for (Vector2 point : std::vector< Vector2 >{{0, -5},
+                                                {6, 0},
+                                                {-20, 40},
+                                                {405, 50},
+                                                {999, 10},
+                                                {311, 100},
+                                                {319, 120},
+                                                {999, 999}}) {
+        std::cout << positions.hit_test(point) << " ";
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    print("hello world", {1000, 1000});
+    print("one\ntwo\n\nthree", {1000, 1000});
+    // 5 glyphs fit on a line of 100
+    print("abc defg hi", {100, 1000});
+    print("abcdefghijkl", {100, 1000});
+    print("a b c d e f g h", {40, 120});
+    testSubscript();
+    testParagraphs();
+    testPositions();
+
+    return 0;
+}
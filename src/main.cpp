@@ -1,8 +1,9 @@
 #include "editor.hpp"
 
-int main() {
+int main(int argc, char** argv) {
     Editor app;
     app.Init();
+    if (argc > 1) app.Open(argv[1]);
     while (!app.WindowClosed()) app.Run();
     app.Close();
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "outline/outline.hpp"
+
+#include <algorithm>
+
+void Outline::rebuild(const Rope& text) {
+    mHeadings = scan(text, 0, text.length());
+}
+
+void Outline::update(const Rope& text, std::size_t position,
+                     std::size_t removed, std::size_t inserted) {
+    // the lines touched by the edit, in the new text
+    std::size_t start = position - text.pos_from_index(position).second;
+    std::size_t last = text.pos_from_index(position + inserted).first;
+    std::size_t end = text.find_line_start(last + 1);
+
+    // and where they were before it
+    std::size_t oldEnd = end - inserted + removed;
+
+    auto by_index = [](const Heading& heading, std::size_t index) {
+        return heading.index < index;
+    };
+    auto first =
+        std::lower_bound(mHeadings.begin(), mHeadings.end(), start, by_index);
+    auto after = std::lower_bound(first, mHeadings.end(), oldEnd, by_index);
+
+    for (auto it = after; it != mHeadings.end(); ++it) {
+        it->index = it->index + inserted - removed;
+    }
+
+    std::vector< Heading > touched = scan(text, start, end);
+    first = mHeadings.erase(first, after);
+    mHeadings.insert(first, std::make_move_iterator(touched.begin()),
+                     std::make_move_iterator(touched.end()));
+}
+
+void Outline::update(const Rope& text, const std::vector< Change >& changes) {
+    if (changes.size() == 1) {
+        const Change& change = changes.front();
+        update(text, change.position, change.removed, change.inserted);
+        return;
+    }
+
+    std::vector< Heading > headings;
+    headings.reserve(mHeadings.size());
+    auto old = mHeadings.begin();
+
+    // characters added by the changes before the current one
+    std::ptrdiff_t shift = 0;
+    auto keep = [&](Heading& heading) {
+        heading.index += shift;
+        headings.push_back(std::move(heading));
+    };
+
+    for (std::size_t i = 0; i < changes.size();) {
+        // the lines touched by the change in the new text, together with
+        // those of the next changes on them
+        std::size_t position = changes[i].position + shift;
+        std::size_t start = position - text.pos_from_index(position).second;
+        std::ptrdiff_t next = shift;
+        std::size_t end = start;
+        do {
+            const Change& change = changes[i++];
+            std::size_t changed = change.position + next + change.inserted;
+            next += change.inserted;
+            next -= change.removed;
+            end = text.find_line_start(text.pos_from_index(changed).first + 1);
+        } while (i < changes.size() && changes[i].position + next < end);
+
+        // the headings before them only move, those in them are read again
+        std::size_t oldStart = start - shift;
+        std::size_t oldEnd = end - next;
+        for (; old != mHeadings.end() && old->index < oldStart; ++old) {
+            keep(*old);
+        }
+        while (old != mHeadings.end() && old->index < oldEnd) ++old;
+
+        std::vector< Heading > touched = scan(text, start, end);
+        headings.insert(headings.end(),
+                        std::make_move_iterator(touched.begin()),
+                        std::make_move_iterator(touched.end()));
+        shift = next;
+    }
+    for (; old != mHeadings.end(); ++old) keep(*old);
+
+    mHeadings = std::move(headings);
+}
+
+const std::vector< Outline::Heading >& Outline::headings() const {
+    return mHeadings;
+}
+
+std::vector< Outline::Heading > Outline::scan(const Rope& text,
+                                              std::size_t start,
+                                              std::size_t end) {
+    std::vector< Heading > headings;
+    if (start >= end) return headings;
+
+    enum class State { LineStart, Markers, Text, Skip };
+    State state = State::LineStart;
+    Heading heading{};
+    std::size_t index = start;
+
+    // a leaf at a time, the text can be far larger than its headings
+    text.subrope(start, end - start).for_each_chunk([&](const nstring& chunk) {
+        for (std::size_t i = 0; i < chunk.length(); ++i, ++index) {
+            const nchar& c = chunk[i];
+            int codepoint = c.codepoint();
+
+            if (codepoint == '\n') {
+                if (state == State::Text) headings.push_back(heading);
+                state = State::LineStart;
+                continue;
+            }
+
+            switch (state) {
+                case State::LineStart:
+                    state = codepoint == '#' ? State::Markers : State::Skip;
+                    heading = {1, index, nstring()};
+                    break;
+                case State::Markers:
+                    if (codepoint == '#' && heading.level < maxLevel) {
+                        ++heading.level;
+                    } else {
+                        state = codepoint == ' ' ? State::Text : State::Skip;
+                    }
+                    break;
+                case State::Text:
+                    if (heading.text.length() || codepoint != ' ') {
+                        heading.text += c;
+                    }
+                    break;
+                case State::Skip:
+                    break;
+            }
+        }
+    });
+    if (state == State::Text) headings.push_back(heading);
+
+    return headings;
+}
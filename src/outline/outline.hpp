@@ -0,0 +1,55 @@
+#ifndef OUTLINE_OUTLINE_HPP
+#define OUTLINE_OUTLINE_HPP
+
+#include <vector>
+
+#include "rope/rope.hpp"
+
+/**
+ * @brief The headings of a text, for the outline.
+ * @details A heading is a line starting with one to maxLevel '#' and a
+ * space, the number of '#' being its level. The headings are kept sorted by
+ * position; an edit only rereads the lines it touched and moves the headings
+ * after them, so listing them never reads the text.
+ */
+class Outline {
+public:
+    // `removed` characters at position replaced by `inserted` ones
+    struct Change {
+        std::size_t position{};
+        std::size_t removed{};
+        std::size_t inserted{};
+    };
+
+    struct Heading {
+        std::size_t level{};
+        // index of the first '#' of the line
+        std::size_t index{};
+        // the rest of the line, without the markers and the spaces after
+        nstring text{};
+    };
+
+    static constexpr std::size_t maxLevel = 5;
+
+    // Reads all of text
+    void rebuild(const Rope& text);
+    // text is the one indexed with `removed` characters at position replaced
+    // by `inserted` ones
+    void update(const Rope& text, std::size_t position, std::size_t removed,
+                std::size_t inserted);
+    // Several changes at once, sorted and not overlapping, their positions
+    // in the text before them
+    void update(const Rope& text, const std::vector< Change >& changes);
+
+    const std::vector< Heading >& headings() const;
+
+private:
+    // Headings of the lines in [start, end) of text, start being a line
+    // start and end one or the end of the text
+    static std::vector< Heading > scan(const Rope& text, std::size_t start,
+                                       std::size_t end);
+
+    std::vector< Heading > mHeadings{};
+};
+
+#endif  // OUTLINE_OUTLINE_HPP
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "outline/outline.hpp"
+
+void print(const Outline& outline) {
+    for (const auto& heading : outline.headings()) {
+        std::cout << "  " << heading.level << " @" << heading.index << " "
+                  << heading.text.to_string() << std::endl;
+    }
+}
+
+void testScan() {
+    Rope text(
+        "# Title\n"
+        "text # not a heading\n"
+        "## Part  one\n"
+        "#no space\n"
+        "###### too deep\n"
+        "#####   Five\n"
+        "# ");
+
+    Outline outline;
+    outline.rebuild(text);
+    std::cout << "Scan:" << std::endl;
+    print(outline);
+}
+
+void testUpdate() {
+    Rope text("# One\nbody\n## Two\nbody\n# Three\n");
+    Outline outline;
+    outline.rebuild(text);
+
+    // a line feed splits a heading, the ones after move
+    Rope edited = text.insert(3, nstring("\n# "));
+    outline.update(edited, 3, 0, 3);
+    std::cout << "Split:" << std::endl;
+    print(outline);
+
+    // joining the lines again
+    outline.update(text, 3, 3, 0);
+    std::cout << "Joined:" << std::endl;
+    print(outline);
+}
+
+void testRandomEdits() {
+    // every update has to end where reading the whole text again does
+    std::mt19937 rng(3);
+    const char* pieces[] = {"# ", "## x", "\n", "\n# y\n", "#", " ", "ab"};
+
+    Rope text("# Start\n");
+    Outline outline;
+    outline.rebuild(text);
+
+    bool same = true;
+    std::size_t most = 0;
+    for (int step = 0; step < 3000; ++step) {
+        std::size_t position = rng() % (text.length() + 1);
+        std::size_t removed =
+            rng() % 3 ? 0 : std::min< std::size_t >(rng() % 6,
+                                                    text.length() - position);
+        nstring inserted(rng() % 4 ? pieces[rng() % 7] : "");
+
+        text = text.replace(position, removed, inserted);
+        outline.update(text, position, removed, inserted.length());
+
+        Outline expected;
+        expected.rebuild(text);
+        const auto& got = outline.headings();
+        const auto& want = expected.headings();
+        same &= got.size() == want.size();
+        for (std::size_t i = 0; same && i < got.size(); ++i) {
+            same = got[i].level == want[i].level &&
+                   got[i].index == want[i].index &&
+                   got[i].text.to_string() == want[i].text.to_string();
+        }
+        most = std::max(most, got.size());
+    }
+    std::cout << "Random edits: same " << same << ", up to " << most
+              << " headings" << std::endl;
+}
+
+void testRandomSplices() {
+    // changes at several places at once, as multiple cursors make them
+    std::mt19937 rng(5);
+    const char* pieces[] = {"# ", "## x", "\n", "\n# y\n", "#", " ", "ab"};
+
+    Rope text("# Start\n## Next\nbody\n");
+    Outline outline;
+    outline.rebuild(text);
+
+    bool same = true;
+    for (int step = 0; step < 2000; ++step) {
+        std::vector< Rope::Splice > splices;
+        std::vector< Outline::Change > changes;
+        std::size_t position = 0;
+        while (position <= text.length() && splices.size() < 4) {
+            position += rng() % 8;
+            if (position > text.length()) break;
+            std::size_t removed = std::min< std::size_t >(
+                rng() % 3, text.length() - position);
+            nstring inserted(rng() % 3 ? pieces[rng() % 7] : "");
+
+            splices.push_back({position, removed, inserted});
+            changes.push_back({position, removed, inserted.length()});
+            position += removed + 1;
+        }
+        if (splices.empty()) continue;
+
+        text = text.splice(splices);
+        outline.update(text, changes);
+
+        Outline expected;
+        expected.rebuild(text);
+        const auto& got = outline.headings();
+        const auto& want = expected.headings();
+        same &= got.size() == want.size();
+        for (std::size_t i = 0; same && i < got.size(); ++i) {
+            same = got[i].level == want[i].level &&
+                   got[i].index == want[i].index &&
+                   got[i].text.to_string() == want[i].text.to_string();
+        }
+    }
+    std::cout << "Random splices: same " << same << std::endl;
+}
+
+int main() {
+    testScan();
+    testUpdate();
+    testRandomEdits();
+    testRandomSplices();
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "profile/profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace profile {
+    namespace {
+        std::uint32_t thread_number() {
+            static std::atomic< std::uint32_t > next{1};
+            thread_local std::uint32_t number = next++;
+            return number;
+        }
+
+        double percentile(std::vector< float > durations, double fraction) {
+            if (durations.empty()) return 0;
+
+            auto nth = durations.begin() +
+                       static_cast< std::size_t >(fraction *
+                                                  (durations.size() - 1));
+            std::nth_element(durations.begin(), nth, durations.end());
+            return *nth;
+        }
+
+        void write_json_string(std::ostream& out, std::string_view text) {
+            out << '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << '"';
+        }
+    }  // namespace
+
+    Profiler::Profiler() : mEpoch{Clock::now()} {}
+
+    void Profiler::set_enabled(bool enabled) {
+        mEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool Profiler::enabled() const {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    void Profiler::record(const char* name, Clock::time_point start,
+                          Clock::time_point end) {
+        using std::chrono::nanoseconds;
+        Event event{name,
+                    std::chrono::duration_cast< nanoseconds >(start - mEpoch)
+                        .count(),
+                    std::chrono::duration_cast< nanoseconds >(end - start)
+                        .count(),
+                    thread_number()};
+        float ms = event.duration / 1e6f;
+
+        std::lock_guard< std::mutex > lock(mMutex);
+
+        if (mEvents.size() < eventCapacity) {
+            mEvents.push_back(event);
+        } else {
+            mEvents[mNextEvent] = event;
+        }
+        mNextEvent = (mNextEvent + 1) % eventCapacity;
+
+        Window& window = mWindows[name];
+        if (window.durations.size() < windowSize) {
+            window.durations.push_back(ms);
+        } else {
+            window.durations[window.count % windowSize] = ms;
+        }
+        ++window.count;
+    }
+
+    std::vector< Profiler::Stat > Profiler::stats() const {
+        std::vector< Stat > stats;
+        {
+            std::lock_guard< std::mutex > lock(mMutex);
+            for (const auto& [name, window] : mWindows) {
+                stats.push_back({name, window.count,
+                                 percentile(window.durations, 0.5),
+                                 percentile(window.durations, 0.99)});
+            }
+        }
+
+        std::sort(stats.begin(), stats.end(),
+                  [](const Stat& a, const Stat& b) { return a.name < b.name; });
+        return stats;
+    }
+
+    std::vector< Profiler::Event > Profiler::events() const {
+        std::lock_guard< std::mutex > lock(mMutex);
+
+        // once full, the next slot holds the oldest event
+        std::vector< Event > events;
+        events.reserve(mEvents.size());
+        std::size_t first = mEvents.size() < eventCapacity ? 0 : mNextEvent;
+        for (std::size_t i = 0; i < mEvents.size(); ++i) {
+            events.push_back(mEvents[(first + i) % mEvents.size()]);
+        }
+        return events;
+    }
+
+    bool Profiler::write_trace(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        // complete events ("X"), timestamps in microseconds
+        out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+        bool first = true;
+        for (const Event& event : events()) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                << ",\"ts\":" << event.start / 1000.0
+                << ",\"dur\":" << event.duration / 1000.0 << "}";
+            first = false;
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        return !!out;
+    }
+
+    void Profiler::clear() {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mEvents.clear();
+        mNextEvent = 0;
+        mWindows.clear();
+    }
+
+    Profiler& profiler() {
+        static Profiler instance;
+        return instance;
+    }
+
+}  // namespace profile
@@ -0,0 +1,117 @@
+#ifndef PROFILE_PROFILER_HPP
+#define PROFILE_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace profile {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Timings of named scopes, for the overlay and for traces.
+     * @details Every finished scope is kept twice: in a ring of the last
+     * eventCapacity events, written out as a Chrome trace on demand, and in
+     * a rolling window of the last windowSize durations of its name, for
+     * percentiles. Scopes may finish on any thread. While disabled a scope
+     * costs one relaxed atomic load.
+     *
+     * Names are not copied, they must outlive the profiler (string
+     * literals).
+     */
+    class Profiler {
+    public:
+        static constexpr std::size_t eventCapacity = 1 << 16;
+        static constexpr std::size_t windowSize = 256;
+
+        struct Event {
+            const char* name{};
+            std::int64_t start{};  // ns since the profiler was made
+            std::int64_t duration{};
+            std::uint32_t thread{};
+        };
+
+        struct Stat {
+            std::string_view name{};
+            std::size_t count{};  // ever recorded
+            double p50{};         // ms, over the window
+            double p99{};
+        };
+
+        Profiler();
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        void set_enabled(bool enabled);
+        bool enabled() const;
+
+        void record(const char* name, Clock::time_point start,
+                    Clock::time_point end);
+
+        // By name
+        std::vector< Stat > stats() const;
+        // The retained events, oldest first
+        std::vector< Event > events() const;
+
+        /**
+         * @brief Write the retained events as Chrome trace-event JSON, for
+         * chrome://tracing or Perfetto.
+         * @return False if the file could not be written.
+         */
+        bool write_trace(const std::string& path) const;
+
+        void clear();
+
+    private:
+        struct Window {
+            std::vector< float > durations{};
+            std::size_t count{};
+        };
+
+        std::atomic< bool > mEnabled{false};
+        Clock::time_point mEpoch{};
+
+        mutable std::mutex mMutex{};
+        std::vector< Event > mEvents{};
+        std::size_t mNextEvent{0};
+        std::unordered_map< std::string_view, Window > mWindows{};
+    };
+
+    // The profiler every Scope reports to
+    Profiler& profiler();
+
+    // Times the enclosing scope, see PROFILE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* name)
+            : mName{profiler().enabled() ? name : nullptr} {
+            if (mName) mStart = Clock::now();
+        }
+
+        ~Scope() {
+            if (mName) profiler().record(mName, mStart, Clock::now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* mName{};
+        Clock::time_point mStart{};
+    };
+
+}  // namespace profile
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing block under `name`, a string literal
+#define PROFILE_SCOPE(name) \
+    ::profile::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#endif  // PROFILE_PROFILER_HPP
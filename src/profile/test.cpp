@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "profile/profiler.hpp"
+
+using profile::Clock;
+using profile::Profiler;
+
+void testPercentiles() {
+    Profiler profiler;
+    Clock::time_point start = Clock::now();
+    for (int ms = 1; ms <= 100; ++ms) {
+        profiler.record("step", start, start + std::chrono::milliseconds(ms));
+    }
+
+    auto stats = profiler.stats();
+    std::cout << "Stats:    " << stats.size() << " " << stats[0].name << " "
+              << stats[0].count << std::endl;
+    std::cout << "p50/p99:  " << stats[0].p50 << " " << stats[0].p99
+              << std::endl;
+}
+
+void testScopes() {
+    auto& profiler = profile::profiler();
+
+    // disabled scopes record nothing
+    { PROFILE_SCOPE("off"); }
+
+    profiler.set_enabled(true);
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i) PROFILE_SCOPE("worker");
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // one scope costs two clock reads and a lock
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < 100000; ++i) PROFILE_SCOPE("cost");
+    double ns = std::chrono::duration< double, std::nano >(Clock::now() -
+                                                           start)
+                    .count() /
+                100000;
+    profiler.set_enabled(false);
+
+    auto stats = profiler.stats();
+    std::cout << "Scopes:   ";
+    for (const auto& stat : stats) {
+        std::cout << stat.name << " " << stat.count << "  ";
+    }
+    std::cout << std::endl;
+    std::cout << "Retained: " << profiler.events().size() << std::endl;
+    std::cout << "Scope ns: " << ns << std::endl;
+}
+
+void testTrace() {
+    Profiler profiler;
+    Clock::time_point start = Clock::now();
+    profiler.record("frame", start, start + std::chrono::microseconds(1500));
+    profiler.record("a \"quoted\" name", start, start);
+
+    std::string path = "profile_test_trace.json";
+    bool written = profiler.write_trace(path);
+
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    std::remove(path.c_str());
+
+    std::cout << "Trace:    " << written << std::endl << text.str();
+}
+
+int main() {
+    testPercentiles();
+    testScopes();
+    testTrace();
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "render/tile_cache.hpp"
+
+TileCache::~TileCache() { clear(); }
+
+TileCache::Key TileCache::mix(Key key, std::uint64_t value) {
+    // FNV-1a over the bytes of the value
+    if (key == 0) key = 14695981039346656037ull;
+    for (int i = 0; i < 8; ++i) {
+        key ^= (value >> (8 * i)) & 0xff;
+        key *= 1099511628211ull;
+    }
+    return key;
+}
+
+bool TileCache::draw(Key key, int width, int height, Vector2 position,
+                     const Painter& paint, Color background) {
+    if (width <= 0 || height <= 0) return false;
+
+    auto it = mIndex.find(key);
+    if (it == mIndex.end()) {
+        RenderTexture2D texture = LoadRenderTexture(width, height);
+        if (texture.id == 0) return false;
+
+        BeginTextureMode(texture);
+        ClearBackground(background);
+        paint(Vector2{0, 0});
+        EndTextureMode();
+
+        std::size_t bytes = static_cast< std::size_t >(width) * height * 4;
+        mTiles.push_front({key, texture, bytes});
+        it = mIndex.emplace(key, mTiles.begin()).first;
+        mBytes += bytes;
+        evict();
+    } else {
+        mTiles.splice(mTiles.begin(), mTiles, it->second);
+    }
+
+    // render textures are stored bottom up
+    const Texture2D& texture = it->second->texture.texture;
+    float textureWidth = texture.width, textureHeight = texture.height;
+    DrawTextureRec(texture, Rectangle{0, 0, textureWidth, -textureHeight},
+                   position, WHITE);
+    return true;
+}
+
+void TileCache::clear() {
+    for (auto& tile : mTiles) UnloadRenderTexture(tile.texture);
+    mTiles.clear();
+    mIndex.clear();
+    mBytes = 0;
+}
+
+void TileCache::set_budget(std::size_t bytes) {
+    mBudget = bytes;
+    evict();
+}
+
+std::size_t TileCache::bytes() const { return mBytes; }
+
+std::size_t TileCache::size() const { return mTiles.size(); }
+
+void TileCache::evict() {
+    // the tile drawn last stays, even if it alone is over the budget
+    while (mBytes > mBudget && mTiles.size() > 1) {
+        Tile& tile = mTiles.back();
+        UnloadRenderTexture(tile.texture);
+        mBytes -= tile.bytes;
+        mIndex.erase(tile.key);
+        mTiles.pop_back();
+    }
+}
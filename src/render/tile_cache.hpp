@@ -0,0 +1,75 @@
+#ifndef RENDER_TILE_CACHE_HPP
+#define RENDER_TILE_CACHE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include "raylib.h"
+
+/**
+ * @brief Rendered lines kept as textures, drawn again while they look the
+ * same.
+ * @details A tile is keyed by a hash of everything that decides what the
+ * line looks like (its characters, their styles and its layout), so a
+ * changed line simply misses and gets a new tile; the stale one is never
+ * hit again and ages out. The least recently drawn tiles are unloaded once
+ * their textures take more than the budget of video memory.
+ *
+ * Tiles are opaque, cleared to the page colour: text blended onto them
+ * looks exactly as if blended onto the page. If the GL driver cannot make a
+ * render texture, draw() fails and the caller draws the line itself.
+ *
+ * Needs the window: textures are made while drawing and must be released
+ * with clear() before the window is closed.
+ */
+class TileCache {
+public:
+    using Key = std::uint64_t;
+    // Draws the tile with its top left corner at `origin`
+    using Painter = std::function< void(Vector2 origin) >;
+
+    static constexpr std::size_t defaultBudget = 64 << 20;
+
+    TileCache() = default;
+    ~TileCache();
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    // Folds `value` into a key
+    static Key mix(Key key, std::uint64_t value);
+
+    /**
+     * @brief Draw the tile of `key` at `position`, painting it first if it
+     * is not cached.
+     * @return False if no tile could be made, nothing was drawn then.
+     */
+    bool draw(Key key, int width, int height, Vector2 position,
+              const Painter& paint, Color background);
+
+    void clear();
+
+    void set_budget(std::size_t bytes);
+    // Video memory of the cached tiles
+    std::size_t bytes() const;
+    std::size_t size() const;
+
+private:
+    struct Tile {
+        Key key{};
+        RenderTexture2D texture{};
+        std::size_t bytes{};
+    };
+
+    void evict();
+
+    // most recently drawn first
+    std::list< Tile > mTiles{};
+    std::unordered_map< Key, std::list< Tile >::iterator > mIndex{};
+    std::size_t mBytes{0};
+    std::size_t mBudget{defaultBudget};
+};
+
+#endif  // RENDER_TILE_CACHE_HPP
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rope/builder.hpp"
+#include "rope/rope.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Moves a cursor around a document of a million short lines the way Document
+// does (line/column kept, converted to an index when needed) and reports the
+// cost of each conversion. The results are checked against line starts
+// computed from the text itself.
+
+std::size_t lineCount = 1000000;
+constexpr std::size_t operationCount = 200000;
+
+struct Cursor {
+    std::size_t line;
+    std::size_t column;
+};
+
+// Document::cursor_move_next_char
+void next_char(const Rope& rope, Cursor& cursor) {
+    if (cursor.column == rope.line_length(cursor.line)) {
+        if (cursor.line + 1 < rope.line_count()) {
+            ++cursor.line;
+            cursor.column = 0;
+        }
+    } else {
+        ++cursor.column;
+    }
+}
+
+// Document::cursor_move_prev_char
+void prev_char(const Rope& rope, Cursor& cursor) {
+    if (cursor.column > 0) {
+        --cursor.column;
+    } else if (cursor.line > 0) {
+        --cursor.line;
+        cursor.column = rope.line_length(cursor.line);
+    }
+}
+
+template < typename Step >
+double time_us(Step&& step) {
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < operationCount; ++i) step(i);
+    return std::chrono::duration< double, std::micro >(Clock::now() - start)
+               .count() /
+           operationCount;
+}
+
+void print(const std::string& name, double us) {
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << us
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) lineCount = std::stoul(argv[1]);
+
+    std::mt19937 rng(2024);
+    std::vector< std::size_t > lineStarts{0};
+
+    rope::Builder builder;
+    for (std::size_t line = 0; line < lineCount; ++line) {
+        std::size_t length = rng() % 12;
+        for (std::size_t i = 0; i < length; ++i) {
+            builder.append(static_cast< int >("etaoin shrdlu"[rng() % 13]));
+        }
+        builder.append('\n');
+        lineStarts.push_back(builder.length());
+    }
+    Rope rope = builder.build();
+
+    // the last line of a text that ends in a line feed counts the line feed,
+    // so the cursor can be placed at the very end
+    auto expectedLength = [&](std::size_t line) {
+        std::size_t length = lineStarts[line + 1] - lineStarts[line] - 1;
+        return line + 1 == lineCount ? length + 1 : length;
+    };
+
+    std::cout << lineCount << " lines, " << rope.length() << " characters, "
+              << operationCount << " operations each" << std::endl;
+    std::cout << std::left << std::setw(16) << "operation" << std::right
+              << std::setw(10) << "us" << std::endl;
+
+    bool consistent = rope.line_count() == lineCount;
+    std::vector< std::size_t > lines(operationCount), indices(operationCount);
+    for (std::size_t i = 0; i < operationCount; ++i) {
+        lines[i] = rng() % lineCount;
+        indices[i] = rng() % rope.length();
+    }
+
+    print("line_length", time_us([&](std::size_t i) {
+              consistent &=
+                  rope.line_length(lines[i]) == expectedLength(lines[i]);
+          }));
+
+    print("index_from_pos", time_us([&](std::size_t i) {
+              std::size_t column = expectedLength(lines[i]) / 2;
+              consistent &= rope.index_from_pos(lines[i], column) ==
+                            lineStarts[lines[i]] + column;
+          }));
+
+    print("pos_from_index", time_us([&](std::size_t i) {
+              auto [line, column] = rope.pos_from_index(indices[i]);
+              consistent &= lineStarts[line] + column == indices[i] &&
+                            column <= expectedLength(line);
+          }));
+
+    Cursor cursor{lineCount / 2, 0};
+    print("next_char", time_us([&](std::size_t) { next_char(rope, cursor); }));
+
+    Cursor walked = cursor;
+    print("prev_char", time_us([&](std::size_t) { prev_char(rope, cursor); }));
+    consistent &= cursor.line == lineCount / 2 && cursor.column == 0 &&
+                  rope.index_from_pos(walked.line, walked.column) ==
+                      rope.index_from_pos(cursor.line, 0) + operationCount;
+
+    std::cout << "Consistent:     " << consistent << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "rope/builder.hpp"
+
+namespace rope {
+
+    void Builder::append(int codepoint) {
+        // built in place, decoding files goes through here per character
+        if (mChunk.length() == 0) mChunk.reserve(Rope::leafSize);
+
+        mChunk.append(codepoint);
+        ++mLength;
+        if (mChunk.length() == Rope::leafSize) flush();
+    }
+
+    void Builder::append(const nchar& c) {
+        if (mChunk.length() == 0) mChunk.reserve(Rope::leafSize);
+
+        mChunk += c;
+        ++mLength;
+        if (mChunk.length() == Rope::leafSize) flush();
+    }
+
+    void Builder::append(const nstring& text) {
+        for (std::size_t i = 0; i < text.length(); ++i) append(text[i]);
+    }
+
+    std::size_t Builder::length() const { return mLength; }
+
+    Rope Builder::build() {
+        flush();
+
+        Rope rope = mLeaves.empty() ? Rope() : Rope::from_leaves(mLeaves);
+        mLeaves.clear();
+        mLength = 0;
+        return rope;
+    }
+
+    void Builder::flush() {
+        if (mChunk.length() == 0) return;
+        mLeaves.push_back(std::make_shared< Leaf >(std::move(mChunk)));
+        mChunk = nstring();
+    }
+
+}  // namespace rope
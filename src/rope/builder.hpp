@@ -0,0 +1,38 @@
+#ifndef ROPE_BUILDER_HPP
+#define ROPE_BUILDER_HPP
+
+#include <vector>
+
+#include "rope/rope.hpp"
+
+namespace rope {
+
+    /**
+     * @brief Builds a balanced rope from text that arrives in pieces.
+     * @details Characters are collected into leaves of Rope::leafSize, and
+     * build() joins the leaves bottom-up into a tree of minimal depth. The
+     * whole text never exists as a single nstring, and nothing is split or
+     * rebalanced on the way.
+     */
+    class Builder {
+    public:
+        void append(int codepoint);
+        void append(const nchar& c);
+        void append(const nstring& text);
+
+        std::size_t length() const;
+
+        // Returns the rope and leaves the builder empty.
+        Rope build();
+
+    private:
+        void flush();
+
+        nstring mChunk{};
+        std::vector< Node::Ptr > mLeaves{};
+        std::size_t mLength{0};
+    };
+
+}  // namespace rope
+
+#endif  // ROPE_BUILDER_HPP
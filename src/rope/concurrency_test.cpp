@@ -0,0 +1,95 @@
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "rope/publisher.hpp"
+
+// One writer keeps editing and publishing while several readers walk every
+// snapshot they get, the same way layout, spell checking, search and autosave
+// use them. Build with -DENABLE_TSAN=ON to run it under ThreadSanitizer.
+
+constexpr int numReaders = 4;
+constexpr int numEdits = 3000;
+
+std::atomic< int > errors{0};
+
+void checkSnapshot(const Rope& rope, std::mt19937& rng) {
+    std::size_t length = 0;
+    std::size_t lineFeeds = 0;
+    rope.for_each_chunk([&](const nstring& chunk) {
+        length += chunk.length();
+        for (std::size_t i = 0; i < chunk.length(); ++i) {
+            if (chunk[i] == '\n') ++lineFeeds;
+        }
+    });
+
+    if (length != rope.length()) ++errors;
+
+    bool trailing = rope.length() && rope[rope.length() - 1] != '\n';
+    if (lineFeeds + trailing != rope.line_count()) ++errors;
+
+    if (rope.length() == 0) return;
+    for (int i = 0; i < 8; ++i) {
+        std::size_t index = rng() % rope.length();
+        auto [line, column] = rope.pos_from_index(index);
+        if (rope.index_from_pos(line, column) != index) ++errors;
+    }
+}
+
+int main() {
+    rope::Publisher publisher;
+    publisher.publish(Rope("rope\nconcurrency\ntest\n"));
+
+    std::vector< std::thread > readers;
+    std::vector< std::size_t > versionsSeen(numReaders);
+
+    for (int r = 0; r < numReaders; ++r) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 rng(r);
+            std::vector< Rope > kept;
+            std::uint64_t seen = 0;
+
+            while (auto snapshot = publisher.wait_newer(seen)) {
+                seen = snapshot->version;
+                ++versionsSeen[r];
+
+                checkSnapshot(snapshot->rope, rng);
+
+                // hold on to some versions for a while, like an autosave
+                // would, so nodes are also released from reader threads
+                kept.push_back(snapshot->rope);
+                if (kept.size() > 16) kept.erase(kept.begin());
+            }
+        });
+    }
+
+    std::mt19937 rng(163);
+    Rope rope = publisher.snapshot().rope;
+    for (int i = 0; i < numEdits; ++i) {
+        std::size_t index = rng() % (rope.length() + 1);
+
+        if (rng() % 3 == 0 && rope.length() > 1) {
+            index = std::min(index, rope.length() - 1);
+            rope = rope.erase(index, 1 + rng() % 4);
+        } else {
+            rope = rope.insert(index, rng() % 4 ? "word " : "line\n");
+        }
+        if (!rope.is_balanced()) rope = rope.rebalance();
+
+        publisher.publish(rope);
+    }
+    publisher.close();
+
+    for (auto& reader : readers) reader.join();
+
+    std::cout << "Edits published: " << numEdits << std::endl;
+    for (int r = 0; r < numReaders; ++r) {
+        std::cout << "Reader " << r << " checked " << versionsSeen[r]
+                  << " versions" << std::endl;
+    }
+    std::cout << "Errors: " << errors << std::endl;
+
+    return errors ? 1 : 0;
+}
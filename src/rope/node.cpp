@@ -11,6 +11,8 @@ namespace rope {
 
     std::size_t Node::depth() const { return mDepth; }
 
+    std::size_t Node::tail_length() const { return mTailLength; }
+
     std::size_t Node::line_count() const { return mLineCount; }
 
     std::size_t Node::word_count() const { return mWordCount; }
@@ -1,20 +1,29 @@
 #ifndef ROPE_NODE_HPP
 #define ROPE_NODE_HPP
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "text/nstring.hpp"
+#include "text/style.hpp"
 
 // Currently use std::string for storing text, after we reimplement a new char
 // type, we will plug it in here.
 
 namespace rope {
 
-    class Node {
+    // Nodes are immutable once constructed: every member is written in the
+    // constructor only and all operations are const, returning new nodes that
+    // share the untouched subtrees. Nodes are always owned through Ptr, so a
+    // subtree can be shared by any number of ropes and threads.
+    class Node : public std::enable_shared_from_this< Node > {
     public:
-        using Ptr = std::shared_ptr< Node >;
+        using Ptr = std::shared_ptr< const Node >;
+        using ChunkVisitor = std::function< void(const nstring&) >;
 
         virtual std::string substr(std::size_t start,
                                    std::size_t length) const = 0;
@@ -27,6 +36,8 @@ namespace rope {
 
         virtual std::pair< Ptr, Ptr > split(std::size_t index) const = 0;
         virtual std::vector< Ptr > leaves() const = 0;
+        virtual void for_each_chunk(const ChunkVisitor& visitor) const = 0;
+        virtual std::vector< Ptr > children() const = 0;
         virtual ~Node() = default;
 
         virtual std::pair< std::size_t, std::size_t > pos_from_index(
@@ -34,12 +45,25 @@ namespace rope {
 
         virtual std::size_t find_line_feed(std::size_t index) const = 0;
         virtual std::size_t find_line_start(std::size_t line_index) const;
+        // Length of a line without its line feed; line_count() is the
+        // trailing partial line
+        virtual std::size_t line_length(std::size_t line_index) const = 0;
 
         virtual std::size_t find_word_start(std::size_t index) const = 0;
         virtual std::size_t find_word_at(std::size_t index) const = 0;
 
+        // Whether every character in [start, start + length) has the type,
+        // stopping at the first one that does not
+        virtual bool has_type(std::size_t start, std::size_t length,
+                              nchar::Type type) const = 0;
+
         std::size_t length() const;
         std::size_t depth() const;
+        // Characters after the last line feed, all of them if there is none
+        std::size_t tail_length() const;
+
+        // Memory owned by this node alone, children excluded.
+        virtual std::size_t bytes() const = 0;
 
         virtual std::size_t line_count() const = 0;
         virtual std::size_t word_count() const = 0;
@@ -55,6 +79,7 @@ namespace rope {
 
         std::size_t mLineCount{};
         std::size_t mLineWeight{};
+        std::size_t mTailLength{};
     };
 
     class Concatenation : public Node {
@@ -74,13 +99,19 @@ namespace rope {
         std::pair< Node::Ptr, Node::Ptr > split(
             std::size_t index) const override;
         std::vector< Node::Ptr > leaves() const override;
+        void for_each_chunk(const ChunkVisitor& visitor) const override;
+        std::vector< Node::Ptr > children() const override;
+        std::size_t bytes() const override;
 
         std::pair< std::size_t, std::size_t > pos_from_index(
             std::size_t index) const override;
 
         std::size_t find_line_feed(std::size_t index) const override;
+        std::size_t line_length(std::size_t line_index) const override;
         std::size_t find_word_start(std::size_t index) const override;
         std::size_t find_word_at(std::size_t index) const override;
+        bool has_type(std::size_t start, std::size_t length,
+                      nchar::Type type) const override;
 
         std::size_t line_count() const override;
         std::size_t word_count() const override;
@@ -96,6 +127,7 @@ namespace rope {
 
         using Node::mLineCount;
         using Node::mLineWeight;
+        using Node::mTailLength;
 
         Node::Ptr mLeft{};
         Node::Ptr mRight{};
@@ -103,7 +135,7 @@ namespace rope {
 
     class Leaf : public Node {
     public:
-        Leaf(const nstring& text);
+        Leaf(nstring text);
         ~Leaf() override = default;
 
         std::string substr(std::size_t start,
@@ -117,13 +149,19 @@ namespace rope {
         std::pair< Node::Ptr, Node::Ptr > split(
             std::size_t index) const override;
         std::vector< Node::Ptr > leaves() const override;
+        void for_each_chunk(const ChunkVisitor& visitor) const override;
+        std::vector< Node::Ptr > children() const override;
+        std::size_t bytes() const override;
 
         std::pair< std::size_t, std::size_t > pos_from_index(
             std::size_t index) const override;
 
         std::size_t find_line_feed(std::size_t index) const override;
+        std::size_t line_length(std::size_t line_index) const override;
         std::size_t find_word_start(std::size_t index) const override;
         std::size_t find_word_at(std::size_t index) const override;
+        bool has_type(std::size_t start, std::size_t length,
+                      nchar::Type type) const override;
 
         std::size_t line_count() const override;
         std::size_t word_count() const override;
@@ -139,6 +177,7 @@ namespace rope {
 
         using Node::mLineCount;
         using Node::mLineWeight;
+        using Node::mTailLength;
 
         nstring mText{};
 
@@ -146,6 +185,166 @@ namespace rope {
         std::vector< int > mWordPos{};
     };
 
+    /**
+     * @brief Leaf over a range of UTF-8 bytes, typically in a mapped file.
+     * @details Only the metrics are known up front (see measure()). The text
+     * is decoded into a Leaf when it is read and kept in a cache shared by
+     * all mapped leaves, which drops the least recently read ones past
+     * cacheBytes, so reading through a huge file does not keep all of it
+     * decoded. Splitting decodes it and returns ordinary leaves, so an edit
+     * only copies the leaves it touches.
+     *
+     * The bytes hold plain text. A Styler, if given, sets the attributes of
+     * the decoded characters, formats that keep styles apart from the text
+     * use it to restore them.
+     *
+     * Reading the text throws std::runtime_error if it does not have the
+     * metrics the leaf was built with, as when a file lies about its chunks.
+     */
+    class MappedLeaf : public Node {
+    public:
+        struct Metrics {
+            std::size_t length{};
+            std::size_t lines{};
+            std::size_t words{};
+        };
+
+        using Styler = std::function< void(nstring&) >;
+
+        // Decoded text kept for all mapped leaves together
+        static constexpr std::size_t cacheBytes = 64 << 20;
+
+        // `data` may share ownership of whatever keeps the bytes alive
+        MappedLeaf(std::shared_ptr< const char > data, std::size_t size,
+                   Metrics metrics, Styler styler = {});
+        ~MappedLeaf() override;
+
+        // What a Leaf of the decoded bytes would count
+        static Metrics measure(const char* data, std::size_t size);
+
+        // The text is in the cache
+        bool is_decoded() const;
+        // Bytes of decoded text in the cache
+        static std::size_t cached_bytes();
+
+        // The undecoded bytes and their styler, to copy the leaf as is
+        const char* raw_data() const;
+        std::size_t raw_size() const;
+        const Styler& styler() const;
+
+        std::string substr(std::size_t start,
+                           std::size_t length) const override;
+        std::string to_string() const override;
+
+        nchar operator[](std::size_t index) const override;
+        nstring subnstr(std::size_t start, std::size_t length) const override;
+        nstring to_nstring() const override;
+
+        std::pair< Node::Ptr, Node::Ptr > split(
+            std::size_t index) const override;
+        std::vector< Node::Ptr > leaves() const override;
+        void for_each_chunk(const ChunkVisitor& visitor) const override;
+        std::vector< Node::Ptr > children() const override;
+        std::size_t bytes() const override;
+
+        std::pair< std::size_t, std::size_t > pos_from_index(
+            std::size_t index) const override;
+
+        std::size_t find_line_feed(std::size_t index) const override;
+        std::size_t line_length(std::size_t line_index) const override;
+        std::size_t find_word_start(std::size_t index) const override;
+        std::size_t find_word_at(std::size_t index) const override;
+        bool has_type(std::size_t start, std::size_t length,
+                      nchar::Type type) const override;
+
+        std::size_t line_count() const override;
+        std::size_t word_count() const override;
+
+    private:
+        // Held by the caller while it reads, the cache may drop it
+        std::shared_ptr< const Leaf > text() const;
+
+        using Node::mLength;
+        using Node::mWeight;
+
+        using Node::mWordCount;
+        using Node::mWordWeight;
+
+        using Node::mLineCount;
+        using Node::mLineWeight;
+        using Node::mTailLength;
+
+        std::shared_ptr< const char > mData{};
+        std::size_t mSize{};
+        Styler mStyler{};
+    };
+
+    /**
+     * @brief A subtree with a StylePatch applied to all of it.
+     * @details The patch is applied to the characters as they are read, so
+     * restyling a range only splits the tree at its ends instead of copying
+     * the text. Everything about the text itself (lengths, lines, words) is
+     * the child's. Styling a styled node merges the two patches rather than
+     * nesting them.
+     */
+    class Styled : public Node {
+    public:
+        Styled(Node::Ptr child, StylePatch patch);
+        ~Styled() override = default;
+
+        const StylePatch& patch() const;
+
+        // The children of the child with the patch moved onto them, empty
+        // if the child is a leaf
+        std::vector< Node::Ptr > pushed_down() const;
+
+        std::string substr(std::size_t start,
+                           std::size_t length) const override;
+        std::string to_string() const override;
+
+        nchar operator[](std::size_t index) const override;
+        nstring subnstr(std::size_t start, std::size_t length) const override;
+        nstring to_nstring() const override;
+
+        std::pair< Node::Ptr, Node::Ptr > split(
+            std::size_t index) const override;
+        std::vector< Node::Ptr > leaves() const override;
+        void for_each_chunk(const ChunkVisitor& visitor) const override;
+        std::vector< Node::Ptr > children() const override;
+        std::size_t bytes() const override;
+
+        std::pair< std::size_t, std::size_t > pos_from_index(
+            std::size_t index) const override;
+
+        std::size_t find_line_feed(std::size_t index) const override;
+        std::size_t line_length(std::size_t line_index) const override;
+        std::size_t find_word_start(std::size_t index) const override;
+        std::size_t find_word_at(std::size_t index) const override;
+        bool has_type(std::size_t start, std::size_t length,
+                      nchar::Type type) const override;
+
+        std::size_t line_count() const override;
+        std::size_t word_count() const override;
+
+    private:
+        Node::Ptr wrap(const Node::Ptr& node) const;
+
+        using Node::mDepth;
+
+        using Node::mLength;
+        using Node::mWeight;
+
+        using Node::mWordCount;
+        using Node::mWordWeight;
+
+        using Node::mLineCount;
+        using Node::mLineWeight;
+        using Node::mTailLength;
+
+        Node::Ptr mChild{};
+        StylePatch mPatch{};
+    };
+
 }  // namespace rope
 
 #endif  // ROPE_NODE_HPP
\ No newline at end of file
@@ -12,6 +12,14 @@ namespace rope {
         mLineWeight = mLeft ? mLeft->line_count() : 0;
         mLineCount = mLineWeight + (mRight ? mRight->line_count() : 0);
 
+        // a line feed on the right ends the tail there, otherwise the right
+        // side continues the tail of the left one
+        std::size_t rightTail = mRight ? mRight->tail_length() : 0;
+        bool rightHasLines = mRight && mRight->line_count();
+        mTailLength = rightHasLines ? rightTail
+                                    : rightTail + (mLeft ? mLeft->tail_length()
+                                                         : 0);
+
         mWordWeight = mLeft ? mLeft->word_count() : 0;
         mWordCount = mWordWeight + (mRight ? mRight->word_count() : 0);
 
@@ -92,6 +100,20 @@ namespace rope {
         return ans;
     }
 
+    void Concatenation::for_each_chunk(const ChunkVisitor& visitor) const {
+        if (mLeft) mLeft->for_each_chunk(visitor);
+        if (mRight) mRight->for_each_chunk(visitor);
+    }
+
+    std::vector< Node::Ptr > Concatenation::children() const {
+        std::vector< Node::Ptr > ans;
+        if (mLeft) ans.push_back(mLeft);
+        if (mRight) ans.push_back(mRight);
+        return ans;
+    }
+
+    std::size_t Concatenation::bytes() const { return sizeof(Concatenation); }
+
     std::pair< std::size_t, std::size_t > Concatenation::pos_from_index(
         std::size_t index) const {
         index = std::min(index, mLength);
@@ -101,13 +123,7 @@ namespace rope {
         }
         auto [line_idx, line_pos] = mRight->pos_from_index(index - mWeight);
 
-        if (line_idx == 0) {
-            line_pos +=
-                mWeight -
-                (mLeft->line_count()
-                     ? mLeft->find_line_feed(mLeft->line_count() - 1) + 1
-                     : 0);
-        }
+        if (line_idx == 0) line_pos += mLeft->tail_length();
 
         return std::make_pair(line_idx + mLineWeight, line_pos);
     }
@@ -120,6 +136,15 @@ namespace rope {
         return mRight->find_line_feed(index - mLineWeight) + mWeight;
     }
 
+    std::size_t Concatenation::line_length(std::size_t line_index) const {
+        if (line_index < mLineWeight) return mLeft->line_length(line_index);
+
+        std::size_t length = mRight->line_length(line_index - mLineWeight);
+        // the first line on the right started on the left
+        if (line_index == mLineWeight) length += mLeft->tail_length();
+        return length;
+    }
+
     std::size_t Concatenation::find_word_start(std::size_t index) const {
         if (index >= mWordCount) throw std::out_of_range("Index out of range");
         if (index < mWordWeight) {
@@ -148,6 +173,20 @@ namespace rope {
         return word_index;
     }
 
+    bool Concatenation::has_type(std::size_t start, std::size_t length,
+                                 nchar::Type type) const {
+        std::size_t end = std::min(start + length, mLength);
+
+        if (start < mWeight &&
+            !mLeft->has_type(start, std::min(end, mWeight) - start, type)) {
+            return false;
+        }
+        if (end <= mWeight) return true;
+
+        std::size_t rightStart = std::max(start, mWeight);
+        return mRight->has_type(rightStart - mWeight, end - rightStart, type);
+    }
+
     std::size_t Concatenation::line_count() const { return mLineCount; }
 
     std::size_t Concatenation::word_count() const { return mWordCount; }
@@ -5,26 +5,30 @@
 #include "rope/node.hpp"
 
 namespace rope {
-    Leaf::Leaf(const nstring& text) : mText{text} {
-        mLength = text.length();
+    Leaf::Leaf(nstring text) : mText{std::move(text)} {
+        mLength = mText.length();
         mWeight = mLength;
 
+        // compare codepoints, comparing nchars would build a temporary per
+        // character and also tell styled newlines apart
         for (std::size_t i = 0; i < mLength; ++i) {
-            if (mText[i] == '\n') {
+            if (mText[i].codepoint() == '\n') {
                 mLinePos.push_back(i);
             }
         }
         mLineCount = mLineWeight = mLinePos.size();
+        mTailLength = mLength - (mLinePos.empty() ? 0 : mLinePos.back() + 1);
 
         // count word in a string
-        nchar prv = "";
+        int prv = 0;
         for (std::size_t i = 0; i < mLength; ++i) {
-            if (mText[i] != '\n' && mText[i] != ' ' && mText[i] != '\t') {
+            int c = mText[i].codepoint();
+            if (c != '\n' && c != ' ' && c != '\t') {
                 if (prv == '\n' || prv == ' ' || prv == '\t') {
                     mWordPos.push_back(i);
                 }
             }
-            prv = mText[i];
+            prv = c;
         }
         mWordCount = mWordWeight = mWordPos.size();
     }
@@ -53,7 +57,18 @@ namespace rope {
     }
 
     std::vector< Node::Ptr > Leaf::leaves() const {
-        return std::vector< Node::Ptr >{std::make_shared< Leaf >(*this)};
+        return std::vector< Node::Ptr >{shared_from_this()};
+    }
+
+    void Leaf::for_each_chunk(const ChunkVisitor& visitor) const {
+        if (mLength) visitor(mText);
+    }
+
+    std::vector< Node::Ptr > Leaf::children() const { return {}; }
+
+    std::size_t Leaf::bytes() const {
+        return sizeof(Leaf) + mText.length() * sizeof(nchar) +
+               (mLinePos.capacity() + mWordPos.capacity()) * sizeof(int);
     }
 
     std::pair< std::size_t, std::size_t > Leaf::pos_from_index(
@@ -79,6 +94,13 @@ namespace rope {
         return mLinePos.at(index);
     }
 
+    std::size_t Leaf::line_length(std::size_t line_index) const {
+        if (line_index >= mLineCount) return mTailLength;
+
+        std::size_t start = line_index ? mLinePos[line_index - 1] + 1 : 0;
+        return mLinePos[line_index] - start;
+    }
+
     std::size_t Leaf::find_word_start(std::size_t index) const {
         if (index >= mWordCount) throw std::out_of_range("Index out of range");
         return mWordPos.at(index);
@@ -100,12 +122,19 @@ namespace rope {
             upper_bound(mWordPos.begin(), mWordPos.end(), (int)index) -
             mWordPos.begin();
 
-        std::cout << word_index << " _ " << index << std::endl;
-
         if (word_index == 0) return 0;
         return word_index - 1;
     }
 
+    bool Leaf::has_type(std::size_t start, std::size_t length,
+                        nchar::Type type) const {
+        std::size_t end = std::min(start + length, mLength);
+        for (std::size_t i = start; i < end; ++i) {
+            if (!(mText[i].getType() & (1 << type))) return false;
+        }
+        return true;
+    }
+
     std::size_t Leaf::line_count() const { return mLineCount; }
 
     std::size_t Leaf::word_count() const { return mWordCount; }
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "rope/node.hpp"
+#include "text/utf8.hpp"
+
+namespace rope {
+    namespace {
+        // Decoded texts of mapped leaves, least recently read last
+        class DecodedCache {
+        public:
+            std::shared_ptr< const Leaf > find(const MappedLeaf* leaf) {
+                std::lock_guard lock(mMutex);
+                auto found = mIndex.find(leaf);
+                if (found == mIndex.end()) return nullptr;
+
+                mEntries.splice(mEntries.begin(), mEntries, found->second);
+                return found->second->text;
+            }
+
+            void insert(const MappedLeaf* leaf,
+                        std::shared_ptr< const Leaf > text) {
+                std::lock_guard lock(mMutex);
+                // another thread decoded it at the same time
+                if (mIndex.count(leaf)) return;
+
+                std::size_t bytes = text->bytes();
+                mEntries.push_front({leaf, std::move(text), bytes});
+                mIndex[leaf] = mEntries.begin();
+                mBytes += bytes;
+
+                // the text just read stays, however large
+                while (mBytes > MappedLeaf::cacheBytes &&
+                       mEntries.size() > 1) {
+                    remove(std::prev(mEntries.end()));
+                }
+            }
+
+            void erase(const MappedLeaf* leaf) {
+                std::lock_guard lock(mMutex);
+                auto found = mIndex.find(leaf);
+                if (found != mIndex.end()) remove(found->second);
+            }
+
+            bool contains(const MappedLeaf* leaf) const {
+                std::lock_guard lock(mMutex);
+                return mIndex.count(leaf);
+            }
+
+            std::size_t bytes() const {
+                std::lock_guard lock(mMutex);
+                return mBytes;
+            }
+
+        private:
+            struct Entry {
+                const MappedLeaf* leaf;
+                std::shared_ptr< const Leaf > text;
+                std::size_t bytes;
+            };
+            using Entries = std::list< Entry >;
+
+            void remove(Entries::iterator entry) {
+                mBytes -= entry->bytes;
+                mIndex.erase(entry->leaf);
+                mEntries.erase(entry);
+            }
+
+            mutable std::mutex mMutex{};
+            Entries mEntries{};
+            std::unordered_map< const MappedLeaf*, Entries::iterator >
+                mIndex{};
+            std::size_t mBytes{0};
+        };
+
+        // never destroyed, leaves in static ropes still erase their entries
+        // at exit
+        DecodedCache& cache() {
+            static auto* instance = new DecodedCache();
+            return *instance;
+        }
+
+        // words go after the last line feed first, every other character
+        // since each needs a space or line feed before it
+        std::size_t tail_words(std::size_t lines, std::size_t words,
+                               std::size_t tail) {
+            return lines ? std::min(words, (tail + 1) / 2) : 0;
+        }
+
+        // whether some text of `length` characters has these lines, words
+        // and characters after its last line feed
+        bool fits(std::size_t length, std::size_t lines, std::size_t words,
+                  std::size_t tail) {
+            if (lines == 0) return tail == length && 2 * words <= length;
+            if (lines > length || tail > length - lines) return false;
+
+            // before the last line feed a word takes two characters, the
+            // other line feeds can stand before words
+            std::size_t headWords = words - tail_words(lines, words, tail);
+            std::size_t headLines = lines - 1;
+            std::size_t used = 2 * headWords +
+                               (headLines > headWords ? headLines - headWords
+                                                      : 0);
+            return used <= length - tail - 1;
+        }
+
+        // replacement characters laid out to the metrics of a text whose
+        // bytes no longer decode to them, the same split as fits()
+        nstring placeholder(std::size_t length, std::size_t lines,
+                            std::size_t words, std::size_t tail) {
+            std::size_t tailWords = tail_words(lines, words, tail);
+            std::size_t headWords = words - tailWords;
+            std::size_t headLines = lines ? lines - 1 : 0;
+            std::size_t head = lines ? length - tail - 1 : length;
+            std::size_t paired = std::min(headLines, headWords);
+            std::size_t used = 2 * headWords + headLines - paired;
+
+            nstring text;
+            text.reserve(length);
+            // a mark after a mark or at the start begins no word
+            for (std::size_t i = used; i < head; ++i) {
+                text += nchar(utf8::replacement);
+            }
+            for (std::size_t i = 0; i < headWords; ++i) {
+                text += nchar(i < paired ? '\n' : ' ');
+                text += nchar(utf8::replacement);
+            }
+            for (std::size_t i = paired; i < headLines; ++i) {
+                text += nchar('\n');
+            }
+            if (lines == 0) return text;
+
+            text += nchar('\n');
+            if (tailWords == 0) {
+                // any mark right after the line feed would begin a word
+                for (std::size_t i = 0; i < tail; ++i) text += nchar(' ');
+                return text;
+            }
+            text += nchar(utf8::replacement);
+            for (std::size_t i = 1; i < tailWords; ++i) {
+                text += nchar(' ');
+                text += nchar(utf8::replacement);
+            }
+            for (std::size_t i = 2 * tailWords - 1; i < tail; ++i) {
+                text += nchar(utf8::replacement);
+            }
+            return text;
+        }
+    }  // namespace
+    MappedLeaf::MappedLeaf(std::shared_ptr< const char > data,
+                           std::size_t size, Metrics metrics,
+                           Styler styler)
+        : mData{std::move(data)}, mSize{size}, mStyler{std::move(styler)} {
+        mLength = mWeight = metrics.length;
+        mLineCount = mLineWeight = metrics.lines;
+        mWordCount = mWordWeight = metrics.words;
+
+        // '\n' and '\r' never occur inside a UTF-8 sequence, so the bytes
+        // after the last of them decode to the tail on their own
+        mTailLength = mLength;
+        if (mLineCount) {
+            std::size_t start = mSize;
+            while (start && mData.get()[start - 1] != '\n' &&
+                   mData.get()[start - 1] != '\r') {
+                --start;
+            }
+
+            mTailLength = 0;
+            auto count = [&](int) { ++mTailLength; };
+            utf8::Decoder decoder;
+            decoder.feed(mData.get() + start, mSize - start, count);
+            decoder.finish(count);
+        }
+
+        // corrupted metrics may contradict the bytes, keep the nearest tail
+        // a placeholder can still have
+        if (!fits(mLength, mLineCount, mWordCount, mTailLength) &&
+            mLineCount <= mLength) {
+            std::size_t wanted = mTailLength;
+            auto distance = [&](std::size_t tail) {
+                return tail > wanted ? tail - wanted : wanted - tail;
+            };
+            for (std::size_t tail = 0; tail <= mLength - mLineCount; ++tail) {
+                if (fits(mLength, mLineCount, mWordCount, tail) &&
+                    (mTailLength == wanted ||
+                     distance(tail) < distance(mTailLength))) {
+                    mTailLength = tail;
+                }
+            }
+        }
+    }
+
+    // the entry is keyed by address, another leaf may get this one
+    MappedLeaf::~MappedLeaf() { cache().erase(this); }
+
+    MappedLeaf::Metrics MappedLeaf::measure(const char* data,
+                                            std::size_t size) {
+        // same rules as the Leaf constructor, without building the text
+        Metrics metrics{};
+        int prv = 0;
+
+        auto count = [&](int c) {
+            bool space = c == '\n' || c == ' ' || c == '\t';
+            bool prvSpace = prv == '\n' || prv == ' ' || prv == '\t';
+
+            if (c == '\n') ++metrics.lines;
+            if (!space && prvSpace) ++metrics.words;
+
+            ++metrics.length;
+            prv = c;
+        };
+
+        utf8::TextDecoder decoder;
+        decoder.feed(data, size, count);
+        decoder.finish(count);
+        return metrics;
+    }
+
+    bool MappedLeaf::is_decoded() const { return cache().contains(this); }
+
+    std::size_t MappedLeaf::cached_bytes() { return cache().bytes(); }
+
+    const char* MappedLeaf::raw_data() const { return mData.get(); }
+
+    std::size_t MappedLeaf::raw_size() const { return mSize; }
+
+    const MappedLeaf::Styler& MappedLeaf::styler() const { return mStyler; }
+
+    std::shared_ptr< const Leaf > MappedLeaf::text() const {
+        if (auto text = cache().find(this)) return text;
+
+        nstring decoded;
+        decoded.reserve(mLength);
+
+        utf8::TextDecoder decoder;
+        auto push = [&](int codepoint) { decoded += nchar(codepoint); };
+        decoder.feed(mData.get(), mSize, push);
+        decoder.finish(push);
+        if (mStyler) mStyler(decoded);
+
+        // the rope above was built from the metrics, reading past them
+        // would index out of the text, so a corrupted chunk shows as
+        // replacement characters instead
+        auto text = std::make_shared< const Leaf >(std::move(decoded));
+        if (text->length() != mLength || text->line_count() != mLineCount ||
+            text->tail_length() != mTailLength ||
+            text->word_count() != mWordCount) {
+            text = std::make_shared< const Leaf >(
+                placeholder(mLength, mLineCount, mWordCount, mTailLength));
+        }
+        cache().insert(this, text);
+        return text;
+    }
+
+    std::string MappedLeaf::substr(std::size_t start,
+                                   std::size_t length) const {
+        return text()->substr(start, length);
+    }
+
+    std::string MappedLeaf::to_string() const { return text()->to_string(); }
+
+    nchar MappedLeaf::operator[](std::size_t index) const {
+        return (*text())[index];
+    }
+
+    nstring MappedLeaf::subnstr(std::size_t start, std::size_t length) const {
+        return text()->subnstr(start, length);
+    }
+
+    nstring MappedLeaf::to_nstring() const { return text()->to_nstring(); }
+
+    std::pair< Node::Ptr, Node::Ptr > MappedLeaf::split(
+        std::size_t index) const {
+        // splitting at either end keeps this leaf mapped
+        if (index == 0) {
+            return std::make_pair(std::make_shared< Leaf >(nstring()),
+                                  shared_from_this());
+        }
+        if (index >= mLength) {
+            return std::make_pair(shared_from_this(),
+                                  std::make_shared< Leaf >(nstring()));
+        }
+        return text()->split(index);
+    }
+
+    std::vector< Node::Ptr > MappedLeaf::leaves() const {
+        return std::vector< Node::Ptr >{shared_from_this()};
+    }
+
+    void MappedLeaf::for_each_chunk(const ChunkVisitor& visitor) const {
+        if (mLength) text()->for_each_chunk(visitor);
+    }
+
+    std::vector< Node::Ptr > MappedLeaf::children() const { return {}; }
+
+    std::size_t MappedLeaf::bytes() const {
+        // the mapped bytes belong to the file, the decoded text to the
+        // cache
+        return sizeof(MappedLeaf);
+    }
+
+    std::pair< std::size_t, std::size_t > MappedLeaf::pos_from_index(
+        std::size_t index) const {
+        return text()->pos_from_index(index);
+    }
+
+    std::size_t MappedLeaf::find_line_feed(std::size_t index) const {
+        return text()->find_line_feed(index);
+    }
+
+    std::size_t MappedLeaf::line_length(std::size_t line_index) const {
+        // the tail is known without decoding
+        if (line_index >= mLineCount) return mTailLength;
+        return text()->line_length(line_index);
+    }
+
+    std::size_t MappedLeaf::find_word_start(std::size_t index) const {
+        return text()->find_word_start(index);
+    }
+
+    std::size_t MappedLeaf::find_word_at(std::size_t index) const {
+        return text()->find_word_at(index);
+    }
+
+    bool MappedLeaf::has_type(std::size_t start, std::size_t length,
+                              nchar::Type type) const {
+        if (start >= mLength || length == 0) return true;
+        // without a styler the decoded text is plain
+        if (!mStyler) return false;
+        return text()->has_type(start, length, type);
+    }
+
+    std::size_t MappedLeaf::line_count() const { return mLineCount; }
+
+    std::size_t MappedLeaf::word_count() const { return mWordCount; }
+
+}  // namespace rope
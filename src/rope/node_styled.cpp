@@ -0,0 +1,112 @@
+#include "rope/node.hpp"
+
+namespace rope {
+    Styled::Styled(Node::Ptr child, StylePatch patch)
+        : mChild{std::move(child)}, mPatch{std::move(patch)} {
+        // one node per subtree, however often it is restyled
+        if (auto styled = dynamic_cast< const Styled* >(mChild.get())) {
+            mPatch = styled->mPatch.then(mPatch);
+            mChild = styled->mChild;
+        }
+
+        mLength = mWeight = mChild->length();
+        mLineCount = mLineWeight = mChild->line_count();
+        mTailLength = mChild->tail_length();
+        mWordCount = mWordWeight = mChild->word_count();
+        mDepth = mChild->depth() + 1;
+    }
+
+    const StylePatch& Styled::patch() const { return mPatch; }
+
+    std::vector< Node::Ptr > Styled::pushed_down() const {
+        std::vector< Node::Ptr > children = mChild->children();
+        for (auto& child : children) child = wrap(child);
+        return children;
+    }
+
+    std::string Styled::substr(std::size_t start, std::size_t length) const {
+        return mChild->substr(start, length);
+    }
+
+    std::string Styled::to_string() const { return mChild->to_string(); }
+
+    nchar Styled::operator[](std::size_t index) const {
+        nchar c = mChild->operator[](index);
+        mPatch.apply(c);
+        return c;
+    }
+
+    nstring Styled::subnstr(std::size_t start, std::size_t length) const {
+        nstring text = mChild->subnstr(start, length);
+        mPatch.apply(text);
+        return text;
+    }
+
+    nstring Styled::to_nstring() const {
+        nstring text = mChild->to_nstring();
+        mPatch.apply(text);
+        return text;
+    }
+
+    std::pair< Node::Ptr, Node::Ptr > Styled::split(std::size_t index) const {
+        auto [left, right] = mChild->split(index);
+        return std::make_pair(wrap(left), wrap(right));
+    }
+
+    std::vector< Node::Ptr > Styled::leaves() const {
+        std::vector< Node::Ptr > leaves = mChild->leaves();
+        for (auto& leaf : leaves) leaf = wrap(leaf);
+        return leaves;
+    }
+
+    void Styled::for_each_chunk(const ChunkVisitor& visitor) const {
+        mChild->for_each_chunk([&](const nstring& chunk) {
+            nstring text = chunk;
+            mPatch.apply(text);
+            visitor(text);
+        });
+    }
+
+    std::vector< Node::Ptr > Styled::children() const { return {mChild}; }
+
+    std::size_t Styled::bytes() const { return sizeof(Styled); }
+
+    std::pair< std::size_t, std::size_t > Styled::pos_from_index(
+        std::size_t index) const {
+        return mChild->pos_from_index(index);
+    }
+
+    std::size_t Styled::find_line_feed(std::size_t index) const {
+        return mChild->find_line_feed(index);
+    }
+
+    std::size_t Styled::line_length(std::size_t line_index) const {
+        return mChild->line_length(line_index);
+    }
+
+    std::size_t Styled::find_word_start(std::size_t index) const {
+        return mChild->find_word_start(index);
+    }
+
+    std::size_t Styled::find_word_at(std::size_t index) const {
+        return mChild->find_word_at(index);
+    }
+
+    bool Styled::has_type(std::size_t start, std::size_t length,
+                          nchar::Type type) const {
+        if (start >= mLength || length == 0) return true;
+        if (mPatch.sets(type)) return true;
+        if (mPatch.clears(type)) return false;
+        return mChild->has_type(start, length, type);
+    }
+
+    std::size_t Styled::line_count() const { return mLineCount; }
+
+    std::size_t Styled::word_count() const { return mWordCount; }
+
+    Node::Ptr Styled::wrap(const Node::Ptr& node) const {
+        if (!node) return node;
+        return std::make_shared< Styled >(node, mPatch);
+    }
+
+}  // namespace rope
@@ -0,0 +1,45 @@
+#include "rope/publisher.hpp"
+
+namespace rope {
+
+    std::uint64_t Publisher::publish(const Rope& rope) {
+        std::uint64_t version;
+        {
+            std::lock_guard lock(mMutex);
+            mRope = rope;
+            version = ++mVersion;
+        }
+        mPublished.notify_all();
+        return version;
+    }
+
+    Publisher::Snapshot Publisher::snapshot() const {
+        std::lock_guard lock(mMutex);
+        return {mRope, mVersion};
+    }
+
+    std::uint64_t Publisher::version() const { return mVersion; }
+
+    std::optional< Publisher::Snapshot > Publisher::wait_newer(
+        std::uint64_t seen) const {
+        std::unique_lock lock(mMutex);
+        mPublished.wait(lock, [&]() { return mClosed || mVersion != seen; });
+
+        if (mClosed) return std::nullopt;
+        return Snapshot{mRope, mVersion};
+    }
+
+    void Publisher::close() {
+        {
+            std::lock_guard lock(mMutex);
+            mClosed = true;
+        }
+        mPublished.notify_all();
+    }
+
+    bool Publisher::closed() const {
+        std::lock_guard lock(mMutex);
+        return mClosed;
+    }
+
+}  // namespace rope
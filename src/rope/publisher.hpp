@@ -0,0 +1,54 @@
+#ifndef ROPE_PUBLISHER_HPP
+#define ROPE_PUBLISHER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+#include "rope/rope.hpp"
+
+namespace rope {
+
+    /**
+     * @brief Hands the latest version of a rope from its writer to readers.
+     * @details Publishing only copies the root pointer under a short lock, so
+     * the writer can publish after every edit. Each version gets an increasing
+     * number; readers can compare it against the last one they processed
+     * without locking, take a snapshot whenever they are ready, or block until
+     * a newer version shows up.
+     */
+    class Publisher {
+    public:
+        struct Snapshot {
+            Rope rope;
+            std::uint64_t version{};
+        };
+
+        std::uint64_t publish(const Rope& rope);
+
+        Snapshot snapshot() const;
+
+        std::uint64_t version() const;
+
+        // Block until a version newer than @p seen is published, returns
+        // nothing once the publisher is closed.
+        std::optional< Snapshot > wait_newer(std::uint64_t seen) const;
+
+        // Wake up every waiting reader for good.
+        void close();
+        bool closed() const;
+
+    private:
+        mutable std::mutex mMutex{};
+        mutable std::condition_variable mPublished{};
+
+        Rope mRope{};
+        std::atomic< std::uint64_t > mVersion{0};
+        bool mClosed{false};
+    };
+
+}  // namespace rope
+
+#endif  // ROPE_PUBLISHER_HPP
@@ -1,5 +1,6 @@
 #include "rope/rope.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "rope.hpp"
@@ -13,12 +14,26 @@ Rope::Rope(const nstring& text) : mRoot{std::make_shared< Leaf >(text)} {}
 
 Rope::Rope(Ptr root) : mRoot{std::move(root)} {}
 
+Rope Rope::from_leaves(const std::vector< Ptr >& leaves) {
+    return merge(leaves);
+}
+
+Rope Rope::concat(const std::vector< Rope >& parts) {
+    std::vector< Ptr > roots;
+    for (const auto& part : parts) {
+        if (part.length()) roots.push_back(part.mRoot);
+    }
+    return roots.empty() ? Rope() : merge(roots);
+}
+
 std::string Rope::to_string() const { return mRoot->to_string(); }
 
 nstring Rope::to_nstring() const { return mRoot->to_nstring(); }
 
 std::size_t Rope::length() const { return mRoot->length(); }
 
+const Rope::Ptr& Rope::root() const { return mRoot; }
+
 nchar Rope::operator[](std::size_t index) const {
     if (index > length()) throw std::out_of_range("Index out of range");
     if (index == length()) return '\0';
@@ -44,7 +59,7 @@ Rope Rope::rebalance() const {
     if (is_balanced()) return *this;
 
     auto leaves = mRoot->leaves();
-    return merge(leaves);
+    return merge(join_small(leaves));
 }
 
 Rope Rope::insert(std::size_t index, const nstring& text) const {
@@ -85,7 +100,11 @@ Rope Rope::replace(std::size_t start, std::size_t length,
 
 Rope Rope::replace(std::size_t start, std::size_t length,
                    const Rope& other) const {
-    return erase(start, length).insert(start, other);
+    // split once on each side instead of erase + insert, so the result keeps
+    // sharing every node outside the replaced range
+    auto [left, rest] = split(start);
+    auto [_, right] = rest.split(length);
+    return left.append(other).append(right);
 }
 
 std::pair< Rope, Rope > Rope::split(std::size_t index) const {
@@ -93,6 +112,119 @@ std::pair< Rope, Rope > Rope::split(std::size_t index) const {
     return std::make_pair(Rope(left), Rope(right));
 }
 
+Rope Rope::subrope(std::size_t start, std::size_t length) const {
+    auto [_, rest] = split(start);
+    return rest.split(length).first;
+}
+
+Rope Rope::restyle(std::size_t start, std::size_t length,
+                   const StylePatch& patch) const {
+    start = std::min(start, this->length());
+    length = std::min(length, this->length() - start);
+    if (length == 0) return *this;
+
+    auto [left, rest] = split(start);
+    auto [middle, right] = rest.split(length);
+    Rope styled(std::make_shared< rope::Styled >(middle.mRoot, patch));
+    return left.append(styled).append(right);
+}
+
+bool Rope::has_type(std::size_t start, std::size_t length,
+                    nchar::Type type) const {
+    return mRoot->has_type(start, length, type);
+}
+
+Rope Rope::splice(const std::vector< Splice >& splices) const {
+    if (splices.empty()) return *this;
+
+    // an insert at the very end belongs to no leaf
+    const Splice* first = splices.data();
+    const Splice* last = first + splices.size();
+    bool atEnd = last[-1].start >= length();
+    if (atEnd) --last;
+
+    Rope result(splice(mRoot, 0, first, last));
+    return atEnd ? result.append(last->text) : result;
+}
+
+Rope::Ptr Rope::splice(const Ptr& node, std::size_t offset,
+                       const Splice* first, const Splice* last) {
+    if (first == last) return node;
+
+    std::size_t end = offset + node->length();
+    bool covered = first + 1 == last && first->start < offset &&
+                   first->start + first->length >= end;
+    if (covered) return std::make_shared< Leaf >(nstring());
+
+    // inserted text keeps its own style, so a style moves below the splices
+    auto children = node->children();
+    if (auto styled = dynamic_cast< const rope::Styled* >(node.get())) {
+        children = styled->pushed_down();
+    }
+    if (children.size() < 2) return splice_leaf(node, offset, first, last);
+
+    // splices starting on the left go left, the last of them may also
+    // remove the beginning of the right side
+    std::size_t middle = offset + children[0]->length();
+    const Splice* right = std::lower_bound(
+        first, last, middle,
+        [](const Splice& candidate, std::size_t index) {
+            return candidate.start < index;
+        });
+    const Splice* rightFirst = right;
+    if (right != first && right[-1].start + right[-1].length > middle) {
+        --rightFirst;
+    }
+
+    return std::make_shared< Concatenation >(
+        splice(children[0], offset, first, right),
+        splice(children[1], middle, rightFirst, last));
+}
+
+Rope::Ptr Rope::splice_leaf(const Ptr& leaf, std::size_t offset,
+                            const Splice* first, const Splice* last) {
+    std::size_t end = offset + leaf->length();
+    std::vector< Rope > pieces;
+    nstring text;
+    text.reserve(leaf->length() + 2 * (last - first));
+    std::size_t copied = offset;
+
+    for (const Splice* edit = first; edit != last; ++edit) {
+        std::size_t from = std::max(edit->start, offset);
+        std::size_t to = std::min(edit->start + edit->length, end);
+
+        text += leaf->subnstr(copied - offset, from - copied);
+        copied = std::max(copied, to);
+
+        // the text goes where the splice starts, large texts keep their nodes
+        if (edit->start < offset) continue;
+        if (edit->text.length() > leafSize) {
+            pieces.push_back(Rope(text));
+            pieces.push_back(edit->text);
+            text = nstring();
+        } else {
+            text += edit->text.to_nstring();
+        }
+    }
+    text += leaf->subnstr(copied - offset, end - copied);
+
+    // many inserts into one leaf should not leave a huge one
+    if (text.length() > 2 * leafSize) {
+        for (std::size_t i = 0; i < text.length(); i += leafSize) {
+            pieces.push_back(Rope(text.substr(i, leafSize)));
+        }
+    } else {
+        pieces.push_back(Rope(std::make_shared< Leaf >(std::move(text))));
+    }
+
+    if (pieces.size() == 1) return pieces.front().mRoot;
+    return concat(pieces).mRoot;
+}
+
+void Rope::for_each_chunk(const Node::ChunkVisitor& visitor) const {
+    mRoot->for_each_chunk(visitor);
+}
+
 Rope::Ptr Rope::merge(const std::vector< Rope::Ptr >& leaves, std::size_t left,
                       std::size_t right) {
     if (left == right) return leaves[left];
@@ -106,6 +238,37 @@ Rope Rope::merge(const std::vector< Rope::Ptr >& leaves) {
     return Rope(merge(leaves, 0, leaves.size() - 1));
 }
 
+std::vector< Rope::Ptr > Rope::join_small(
+    const std::vector< Rope::Ptr >& leaves) {
+    // edits split leaves into ever smaller pieces; without joining them the
+    // leaf count, and with it the cost of every rebalance, grows with the
+    // number of edits
+    std::vector< Rope::Ptr > joined;
+    std::size_t runStart = 0, runLength = 0;
+
+    auto flush = [&](std::size_t end) {
+        if (end - runStart == 1) {
+            joined.push_back(leaves[runStart]);
+        } else if (end > runStart) {
+            nstring text;
+            for (std::size_t i = runStart; i < end; ++i) {
+                text += leaves[i]->to_nstring();
+            }
+            joined.push_back(std::make_shared< Leaf >(text));
+        }
+        runStart = end;
+        runLength = 0;
+    };
+
+    for (std::size_t i = 0; i < leaves.size(); ++i) {
+        if (runLength + leaves[i]->length() > leafSize) flush(i);
+        runLength += leaves[i]->length();
+    }
+    flush(leaves.size());
+
+    return joined;
+}
+
 bool Rope::operator==(const Rope& other) const {
     return mRoot->to_string() == other.mRoot->to_string();
 }
@@ -140,16 +303,16 @@ std::size_t Rope::find_line_start(std::size_t index) const {
 }
 
 std::size_t Rope::line_count() const {
-    return mRoot->line_count() +
-           (length() ? mRoot->operator[](length() - 1) != '\n' : 0);
+    return mRoot->line_count() + (mRoot->tail_length() != 0);
 }
 
 std::size_t Rope::line_length(std::size_t line_index) const {
-    if (line_index == line_count() - 1) {
-        return length() - mRoot->find_line_start(line_index);
-    }
-    return mRoot->find_line_start(line_index + 1) -
-           mRoot->find_line_start(line_index) - 1;
+    std::size_t lineLength = mRoot->line_length(line_index);
+
+    // the last line keeps its line feed, so the cursor can reach the end
+    bool last = line_index + 1 == line_count();
+    if (last && line_index < mRoot->line_count()) ++lineLength;
+    return lineLength;
 }
 
 std::size_t Rope::index_from_pos(std::size_t line_idx,
@@ -3,14 +3,29 @@
 
 #include "rope/node.hpp"
 
+/**
+ * @brief Persistent rope of nchar.
+ * @details Editing operations never modify a rope, they return a new one that
+ * shares every untouched node with the original.
+ *
+ * Thread safety: the nodes are immutable and reference counted atomically, so
+ * a copy of a Rope is a snapshot that can be handed to any thread and read
+ * there (layout, spell checking, search, saving) while the owner keeps
+ * editing. All const member functions may run concurrently. The Rope object
+ * itself is a plain value: assigning to it while another thread reads the same
+ * object is a data race, use rope::Publisher to share the latest version.
+ */
 class Rope {
 private:
     using Node = rope::Node;
 
 public:
     static constexpr std::size_t maxDepth = 64;
+    // Length of the leaves rope::Builder creates; rebalance() joins runs of
+    // adjacent smaller leaves up to this length.
+    static constexpr std::size_t leafSize = 1024;
 
-    using Ptr = std::shared_ptr< Node >;
+    using Ptr = Node::Ptr;
 
     Rope();
     Rope(const nstring& text);
@@ -18,9 +33,19 @@ public:
     ~Rope() = default;
     Rope(Ptr root);
 
+    // Balanced rope over the given leaves, in order. There must be at least
+    // one leaf.
+    static Rope from_leaves(const std::vector< Ptr >& leaves);
+    // Balanced concatenation of the ropes, in order, sharing their nodes
+    static Rope concat(const std::vector< Rope >& parts);
+
     std::string to_string() const;
     nstring to_nstring() const;
     std::size_t length() const;
+
+    // Root of the tree, for code that walks the structure itself
+    const Ptr& root() const;
+
     nchar operator[](std::size_t index) const;
     std::string substr(std::size_t start, std::size_t length) const;
     nstring subnstr(std::size_t start, std::size_t length) const;
@@ -44,7 +69,29 @@ public:
     [[nodiscard]] Rope replace(std::size_t start, std::size_t length,
                                const Rope& other) const;
 
+    // Replaces `length` characters at `start` with `text`
+    struct Splice;
+
+    // Applies splices at increasing positions that do not overlap, in one
+    // pass over the tree: subtrees without a splice are shared and every
+    // leaf with some is rebuilt once, instead of once per splice.
+    [[nodiscard]] Rope splice(const std::vector< Splice >& splices) const;
+
+    // Changes the attributes of [start, start + length) without copying its
+    // characters: the range gets a rope::Styled node that applies the patch
+    // when they are read.
+    [[nodiscard]] Rope restyle(std::size_t start, std::size_t length,
+                               const StylePatch& patch) const;
+    // Whether every character in [start, start + length) has the type
+    bool has_type(std::size_t start, std::size_t length,
+                  nchar::Type type) const;
+
     std::pair< Rope, Rope > split(std::size_t index) const;
+    // The characters in [start, start + length), sharing the nodes inside
+    [[nodiscard]] Rope subrope(std::size_t start, std::size_t length) const;
+
+    // Visit the text leaf by leaf, in order, without flattening the rope.
+    void for_each_chunk(const Node::ChunkVisitor& visitor) const;
 
     std::size_t find_word_start(std::size_t word_index) const;
     std::size_t find_word_at(std::size_t index) const;
@@ -70,7 +117,20 @@ private:
     static Node::Ptr merge(const std::vector< Node::Ptr >& leaves,
                            std::size_t left, std::size_t right);
 
+    static Node::Ptr splice(const Node::Ptr& node, std::size_t offset,
+                            const Splice* first, const Splice* last);
+    static Node::Ptr splice_leaf(const Node::Ptr& leaf, std::size_t offset,
+                                 const Splice* first, const Splice* last);
+
     static Rope merge(const std::vector< Node::Ptr >& leaves);
+    static std::vector< Node::Ptr > join_small(
+        const std::vector< Node::Ptr >& leaves);
+};
+
+struct Rope::Splice {
+    std::size_t start;
+    std::size_t length;
+    Rope text;
 };
 
 #endif  // ROPE_ROPE_HPP
\ No newline at end of file
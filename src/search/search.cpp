@@ -5,6 +5,8 @@
 
 #include <algorithm>
 
+#include "profile/profiler.hpp"
+
 void Search::set_pattern(const Rope& pattern) { mPattern = pattern; }
 
 void Search::set_replacement(const Rope& replacement) {
@@ -14,6 +16,8 @@ void Search::set_replacement(const Rope& replacement) {
 // Z-function is used to find all occurrences of a pattern in a string in linear
 // time https://cp-algorithms.com/string/z-function.html
 void Search::find_in_content(const Rope& text) {
+    PROFILE_SCOPE("Search::find_in_content");
+
     mMatches.clear();
     mMatchIdx.clear();
 
@@ -53,6 +57,8 @@ void Search::find_in_content(const Rope& text) {
 }
 
 Rope Search::replace_in_content(const Rope& text) {
+    PROFILE_SCOPE("Search::replace_in_content");
+
     find_in_content(text);
 
     Rope result = text;
@@ -0,0 +1,206 @@
+#include "spellcheck/spellchecker.hpp"
+
+#include <cctype>
+
+namespace {
+    bool is_word_char(int codepoint) {
+        return codepoint >= 128 || std::isalnum(codepoint);
+    }
+
+    // FNV-1a over the codepoints of a paragraph
+    std::uint64_t hash_paragraph(const std::vector< int >& text) {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (int codepoint : text) {
+            hash ^= static_cast< std::uint32_t >(codepoint);
+            hash *= 1099511628211ULL;
+        }
+        return hash ^ text.size();
+    }
+}  // namespace
+
+SpellChecker::SpellChecker() {}
+
+SpellChecker::~SpellChecker() {
+    mStopping = true;
+    mSnapshots.close();
+
+    if (mWorker.joinable()) mWorker.join();
+}
+
+void SpellChecker::set_dictionary(Dictionary* dictionary,
+                                  const std::string& databasePath) {
+    std::lock_guard lock(mMutex);
+
+    mDictionary = dictionary;
+    mDatabasePath = databasePath;
+    mReady = mDictionary && mDictionary->is_loaded();
+
+    mCache.clear();
+}
+
+void SpellChecker::submit(const Rope& snapshot) {
+    std::lock_guard lock(mMutex);
+    if (!mDictionary) return;
+
+    mSnapshots.publish(snapshot);
+
+    if (!mWorker.joinable()) mWorker = std::thread(&SpellChecker::run, this);
+}
+
+bool SpellChecker::poll(std::vector< Range >& ranges) {
+    std::unique_lock lock(mResultMutex, std::try_to_lock);
+    if (!lock.owns_lock() || mResultVersion == mPolledVersion) return false;
+
+    ranges = mResults;
+    mPolledVersion = mResultVersion;
+    return true;
+}
+
+bool SpellChecker::check(const nstring& word) {
+    if (!ready()) return true;
+
+    std::string key;
+    for (std::size_t i = 0; i < word.length(); ++i) {
+        int codepoint = word[i].codepoint();
+        if (codepoint >= 128) return true;
+        key += static_cast< char >(std::tolower(codepoint));
+    }
+
+    return key.empty() || lookup(key);
+}
+
+bool SpellChecker::ready() const { return mReady; }
+
+void SpellChecker::wait_idle() {
+    std::unique_lock lock(mMutex);
+    mIdle.wait(lock,
+               [&]() { return mCheckedVersion == mSnapshots.version(); });
+}
+
+std::size_t SpellChecker::checked_paragraphs() const {
+    return mCheckedParagraphs;
+}
+
+void SpellChecker::run() {
+    std::uint64_t seen = 0;
+
+    while (auto snapshot = mSnapshots.wait_newer(seen)) {
+        seen = snapshot->version;
+
+        if (!mReady && !mDatabasePath.empty()) {
+            // the dictionary is only touched by this thread until mReady is
+            // set, so it can be loaded without any lock
+            mDictionary->loadDatabase(mDatabasePath);
+            mReady = true;
+        }
+
+        std::vector< Range > ranges;
+        if (mReady && check_snapshot(*snapshot, ranges)) {
+            publish(std::move(ranges));
+        }
+
+        {
+            std::lock_guard lock(mMutex);
+            mCheckedVersion = seen;
+        }
+        mIdle.notify_all();
+    }
+}
+
+bool SpellChecker::check_snapshot(const rope::Publisher::Snapshot& snapshot,
+                                  std::vector< Range >& ranges) {
+    Paragraphs paragraphs;
+    std::vector< int > text;
+    std::size_t paragraphStart = 0;
+    std::size_t index = 0;
+    bool superseded = false;
+
+    auto finish_paragraph = [&]() {
+        std::uint64_t hash = hash_paragraph(text);
+
+        auto it = mParagraphs.find(hash);
+        std::vector< Range > found =
+            it != mParagraphs.end() ? it->second : check_paragraph(text);
+
+        for (const Range& range : found) {
+            ranges.push_back({paragraphStart + range.start, range.length});
+        }
+        paragraphs[hash] = std::move(found);
+
+        text.clear();
+        paragraphStart = index + 1;
+    };
+
+    snapshot.rope.for_each_chunk([&](const nstring& chunk) {
+        if (superseded) return;
+
+        for (std::size_t i = 0; i < chunk.length(); ++i, ++index) {
+            int codepoint = chunk[i].codepoint();
+            if (codepoint != '\n') {
+                text.push_back(codepoint);
+                continue;
+            }
+
+            finish_paragraph();
+
+            // a newer snapshot makes this pass pointless, but keep the
+            // paragraphs checked so far for the next one
+            if (mStopping || mSnapshots.version() != snapshot.version) {
+                superseded = true;
+                break;
+            }
+        }
+    });
+
+    if (!superseded && !text.empty()) finish_paragraph();
+
+    if (superseded) {
+        mParagraphs.merge(paragraphs);
+        return false;
+    }
+
+    mParagraphs = std::move(paragraphs);
+    return true;
+}
+
+std::vector< SpellChecker::Range > SpellChecker::check_paragraph(
+    const std::vector< int >& text) {
+    ++mCheckedParagraphs;
+
+    std::vector< Range > ranges;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (!is_word_char(text[i])) {
+            ++i;
+            continue;
+        }
+
+        std::size_t start = i;
+        std::string key;
+        bool checkable = true;
+
+        for (; i < text.size() && is_word_char(text[i]); ++i) {
+            // the dictionary only knows plain English words
+            if (text[i] >= 128 || std::isdigit(text[i])) checkable = false;
+            if (checkable) key += static_cast< char >(std::tolower(text[i]));
+        }
+
+        if (checkable && !lookup(key)) ranges.push_back({start, i - start});
+    }
+
+    return ranges;
+}
+
+bool SpellChecker::lookup(const std::string& word) {
+    if (auto cached = mCache.find(word)) return *cached;
+
+    bool valid = mDictionary->search(word);
+    mCache.insert(word, valid);
+    return valid;
+}
+
+void SpellChecker::publish(std::vector< Range >&& ranges) {
+    std::lock_guard lock(mResultMutex);
+    mResults = std::move(ranges);
+    ++mResultVersion;
+}
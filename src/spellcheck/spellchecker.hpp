@@ -0,0 +1,103 @@
+#ifndef SPELLCHECK_SPELLCHECKER_HPP
+#define SPELLCHECK_SPELLCHECKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "dictionary/dictionary.hpp"
+#include "rope/publisher.hpp"
+#include "spellcheck/word_cache.hpp"
+
+/**
+ * @brief Whole-document spell checking on a background thread.
+ * @details The UI thread publishes immutable Rope snapshots with submit(),
+ * the worker always picks up the newest one and skips the rest. It walks the
+ * snapshot chunk by chunk, splits it into paragraphs and reuses the results of
+ * every paragraph whose text did not change since the previous pass, so an
+ * edit only costs dictionary lookups for the paragraphs it touched. Misspelled
+ * ranges are published under a separate lock that the UI thread only ever
+ * try-locks in poll(), so rendering never waits for the worker.
+ */
+class SpellChecker {
+public:
+    struct Range {
+        std::size_t start{};
+        std::size_t length{};
+    };
+
+    SpellChecker();
+    ~SpellChecker();
+
+    SpellChecker(const SpellChecker&) = delete;
+    SpellChecker& operator=(const SpellChecker&) = delete;
+
+    /**
+     * @brief Set the dictionary used for lookups, before the first submit().
+     * @param dictionary The dictionary, it must outlive the checker.
+     * @param databasePath If not empty and the dictionary is not loaded yet,
+     * the worker loads it from this path before the first pass.
+     */
+    void set_dictionary(Dictionary* dictionary,
+                        const std::string& databasePath = "");
+
+    void submit(const Rope& snapshot);
+
+    /**
+     * @brief Fetch the latest published ranges without blocking.
+     * @return True if @p ranges was updated.
+     */
+    bool poll(std::vector< Range >& ranges);
+
+    // Cached lookup usable from any thread, unknown words count as valid
+    // until the dictionary is ready.
+    bool check(const nstring& word);
+
+    bool ready() const;
+
+    void wait_idle();
+
+    std::size_t checked_paragraphs() const;
+
+private:
+    using Paragraphs =
+        std::unordered_map< std::uint64_t, std::vector< Range > >;
+
+    void run();
+    bool check_snapshot(const rope::Publisher::Snapshot& snapshot,
+                        std::vector< Range >& ranges);
+    std::vector< Range > check_paragraph(const std::vector< int >& text);
+    bool lookup(const std::string& word);
+    void publish(std::vector< Range >&& ranges);
+
+private:
+    Dictionary* mDictionary{};
+    std::string mDatabasePath{};
+    std::atomic< bool > mReady{false};
+
+    spellcheck::WordCache mCache{};
+
+    // paragraph hash -> misspelled ranges relative to the paragraph start,
+    // only touched by the worker
+    Paragraphs mParagraphs{};
+    std::atomic< std::size_t > mCheckedParagraphs{0};
+
+    rope::Publisher mSnapshots{};
+    std::atomic< bool > mStopping{false};
+
+    std::thread mWorker{};
+    std::mutex mMutex{};
+    std::condition_variable mIdle{};
+    std::uint64_t mCheckedVersion{0};
+
+    std::mutex mResultMutex{};
+    std::vector< Range > mResults{};
+    std::uint64_t mResultVersion{0};
+    std::uint64_t mPolledVersion{0};
+};
+
+#endif  // SPELLCHECK_SPELLCHECKER_HPP
@@ -0,0 +1,39 @@
+#include <iostream>
+
+#include "spellcheck/spellchecker.hpp"
+
+void printMisspelled(const Rope& rope, SpellChecker& checker) {
+    checker.submit(rope);
+    checker.wait_idle();
+
+    std::vector< SpellChecker::Range > ranges;
+    checker.poll(ranges);
+
+    std::cout << "Misspelled (" << ranges.size() << "):";
+    for (const auto& range : ranges) {
+        std::cout << " [" << rope.substr(range.start, range.length) << "]";
+    }
+    std::cout << std::endl;
+    std::cout << "Checked paragraphs: " << checker.checked_paragraphs()
+              << std::endl;
+}
+
+int main() {
+    Dictionary dict;
+    dict.loadDatabase("data/dictionary/english/words.txt");
+
+    SpellChecker checker;
+    checker.set_dictionary(&dict);
+
+    Rope rope("hello wrold\nthis sentence is fine\nsome speling mistaek\n");
+    printMisspelled(rope, checker);
+
+    // only the edited paragraph should be checked again
+    rope = rope.insert(rope.find_line_start(1), "anothr ");
+    printMisspelled(rope, checker);
+
+    std::cout << checker.check("hello") << " " << checker.check("helo")
+              << std::endl;
+
+    return 0;
+}
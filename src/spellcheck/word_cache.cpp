@@ -0,0 +1,46 @@
+#include "spellcheck/word_cache.hpp"
+
+#include <mutex>
+
+namespace spellcheck {
+
+    std::optional< bool > WordCache::find(const std::string& word) const {
+        const Shard& s = shard(word);
+        std::shared_lock lock(s.mutex);
+
+        auto it = s.words.find(word);
+        if (it == s.words.end()) return std::nullopt;
+        return it->second;
+    }
+
+    void WordCache::insert(const std::string& word, bool valid) {
+        Shard& s = shard(word);
+        std::unique_lock lock(s.mutex);
+        s.words[word] = valid;
+    }
+
+    std::size_t WordCache::size() const {
+        std::size_t total = 0;
+        for (const auto& s : mShards) {
+            std::shared_lock lock(s.mutex);
+            total += s.words.size();
+        }
+        return total;
+    }
+
+    void WordCache::clear() {
+        for (auto& s : mShards) {
+            std::unique_lock lock(s.mutex);
+            s.words.clear();
+        }
+    }
+
+    WordCache::Shard& WordCache::shard(const std::string& word) {
+        return mShards[std::hash< std::string >{}(word) % numShards];
+    }
+
+    const WordCache::Shard& WordCache::shard(const std::string& word) const {
+        return mShards[std::hash< std::string >{}(word) % numShards];
+    }
+
+}  // namespace spellcheck
@@ -0,0 +1,39 @@
+#ifndef SPELLCHECK_WORD_CACHE_HPP
+#define SPELLCHECK_WORD_CACHE_HPP
+
+#include <array>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace spellcheck {
+
+    // Memo of dictionary lookups keyed by the lower-cased UTF-8 word. The map
+    // is split into shards so the worker and the UI thread rarely contend on
+    // the same lock, and readers of a shard never block each other.
+    class WordCache {
+    public:
+        static constexpr std::size_t numShards = 16;
+
+        std::optional< bool > find(const std::string& word) const;
+        void insert(const std::string& word, bool valid);
+
+        std::size_t size() const;
+        void clear();
+
+    private:
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map< std::string, bool > words;
+        };
+
+        Shard& shard(const std::string& word);
+        const Shard& shard(const std::string& word) const;
+
+        std::array< Shard, numShards > mShards{};
+    };
+
+}  // namespace spellcheck
+
+#endif  // SPELLCHECK_WORD_CACHE_HPP
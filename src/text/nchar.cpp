@@ -1,15 +1,18 @@
 #include "text/nchar.hpp"
 
 #include "nchar.hpp"
+#include "text/utf8.hpp"
 
 nchar::nchar() {}
 
-nchar::nchar(const nchar& other) { *this = other; }
-
 nchar::nchar(const char* c) { *this = c; }
 
 nchar::nchar(int codepoint) : mCodepoint{codepoint} {}
 
+nchar::nchar(int codepoint, const nchar& style) : nchar(style) {
+    mCodepoint = codepoint;
+}
+
 nchar& nchar::operator=(const nchar& other) {
     mCodepoint = other.mCodepoint;
     mType = other.mType;
@@ -68,6 +71,16 @@ bool nchar::operator==(const nchar& other) const {
 
 bool nchar::operator!=(const nchar& other) const { return !(*this == other); }
 
+bool nchar::sameStyle(const nchar& other) const {
+    auto sameColor = [](Color a, Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    };
+    return mType == other.mType && mFontSize == other.mFontSize &&
+           mFontId == other.mFontId && sameColor(mColor, other.mColor) &&
+           sameColor(mBackgroundColor, other.mBackgroundColor) &&
+           mLink == other.mLink;
+}
+
 int nchar::codepoint() const { return mCodepoint; }
 
 const char* nchar::getChar() const {
@@ -102,7 +115,9 @@ const char* nchar::getChar() const {
 }
 
 std::ostream& operator<<(std::ostream& os, const nchar& nchar) {
-    os << nchar.getChar();
+    std::string text;
+    utf8::append(text, nchar.codepoint());
+    os << text;
     return os;
 }
 
@@ -183,6 +198,6 @@ Color nchar::getBackgroundColor() const { return mBackgroundColor; }
 
 void nchar::setLink(std::string link) { mLink = link; }
 
-std::string nchar::getLink() const { return mLink; }
+const std::string& nchar::getLink() const { return mLink; }
 
 bool nchar::hasLink() const { return !mLink.empty(); }
\ No newline at end of file
@@ -25,14 +25,19 @@ public:
     };
 
     nchar();
-    nchar(const nchar& other);
+    nchar(const nchar& other) = default;
+    nchar(nchar&& other) = default;
     nchar(const char* c);
     nchar(int codepoint);
+    // codepoint with every attribute of style
+    nchar(int codepoint, const nchar& style);
 
     nchar& operator=(const nchar& other);
     nchar& operator=(const char* c);
     bool operator==(const nchar& other) const;
     bool operator!=(const nchar& other) const;
+    // Every attribute but the codepoint is the same
+    bool sameStyle(const nchar& other) const;
 
     int codepoint() const;
     const char* getChar() const;
@@ -63,7 +68,7 @@ public:
     Color getBackgroundColor() const;
 
     void setLink(std::string link);
-    std::string getLink() const;
+    const std::string& getLink() const;
     bool hasLink() const;
 
     bool isBold() const;
@@ -2,6 +2,7 @@
 
 #include <cstring>
 
+#include "text/utf8.hpp"
 #include "text/utils.hpp"
 
 nstring::nstring() {}
@@ -45,22 +46,13 @@ nstring& nstring::operator=(const nstring& other) {
 
 nstring& nstring::operator=(const std::string& str) {
     mChars.clear();
+    mChars.reserve(str.length());
+
+    utf8::Decoder decoder;
+    auto push = [&](int codepoint) { mChars.emplace_back(codepoint); };
+    decoder.feed(str.data(), str.length(), push);
+    decoder.finish(push);
 
-    for (int i = 0; i < str.length();) {
-        if ((str[i] & 0x80) == 0) {
-            mChars.push_back(nchar(str[i]));
-            i += 1;
-        } else if ((str[i] & 0xE0) == 0xC0) {
-            mChars.push_back(nchar(str.substr(i, 2).c_str()));
-            i += 2;
-        } else if ((str[i] & 0xF0) == 0xE0) {
-            mChars.push_back(nchar(str.substr(i, 3).c_str()));
-            i += 3;
-        } else if ((str[i] & 0xF8) == 0xF0) {
-            mChars.push_back(nchar(str.substr(i, 4).c_str()));
-            i += 4;
-        }
-    }
     mLength = mChars.size();
     mFontSize = constants::document::default_font_size;
     mFontId = constants::document::default_font_id;
@@ -112,6 +104,21 @@ nstring nstring::operator+(const nstring& other) const {
 }
 
 nstring& nstring::operator+=(const nchar& other) {
+    mergeStyle(other);
+
+    mChars.push_back(other);
+    mLength++;
+    return *this;
+}
+
+nstring& nstring::append(int codepoint) {
+    mChars.emplace_back(codepoint);
+    mergeStyle(mChars.back());
+    mLength++;
+    return *this;
+}
+
+void nstring::mergeStyle(const nchar& other) {
     mFontSize = std::max(mFontSize, other.getFontSize());
     mColor = (cmpColor(mColor, other.getColor()))
                  ? mColor
@@ -122,10 +129,6 @@ nstring& nstring::operator+=(const nchar& other) {
                            : constants::document::default_background_color;
 
     if (mFontId != other.getFontId()) mFontId = -1;
-
-    mChars.push_back(other);
-    mLength++;
-    return *this;
 }
 
 nstring nstring::operator+(const nchar& other) const {
@@ -148,14 +151,15 @@ std::size_t nstring::length() const { return mChars.size(); }
 
 std::string nstring::to_string() const {
     std::string result;
+    result.reserve(length());
 
-    for (int i = 0; i < length(); ++i) {
-        result += mChars[i].getChar();
-    }
+    for (const nchar& c : mChars) utf8::append(result, c.codepoint());
 
     return result;
 }
 
+void nstring::reserve(std::size_t capacity) { mChars.reserve(capacity); }
+
 const char* nstring::c_str() const {
     std::string result = to_string();
 
@@ -10,12 +10,14 @@ public:
     nstring();
     nstring(const nchar& other);
     nstring(const nstring& other);
+    nstring(nstring&& other) = default;
     nstring(const std::string& str);
     nstring(const char* str);
 
     nstring& operator=(const char* str);
     nstring& operator=(const nchar& other);
     nstring& operator=(const nstring& other);
+    nstring& operator=(nstring&& other) = default;
     nstring& operator=(const std::string& str);
     bool operator==(const nstring& other) const;
     bool operator!=(const nstring& other) const;
@@ -25,11 +27,14 @@ public:
 
     nstring& operator+=(const nchar& other);
     nstring operator+(const nchar& other) const;
+    // Adds a character of the default style, built in place
+    nstring& append(int codepoint);
 
     nchar& operator[](int index);
     const nchar& operator[](int index) const;
 
     std::size_t length() const;
+    void reserve(std::size_t capacity);
     std::string to_string() const;
     const char* c_str() const;
     nstring substr(std::size_t start, std::size_t length) const;
@@ -62,6 +67,8 @@ public:
 private:
     nstring& toggleType(std::size_t start, std::size_t length,
                         nchar::Type type);
+    // Folds the style of a character into the ones of the whole string
+    void mergeStyle(const nchar& other);
 
     std::vector< nchar > mChars{};
     std::size_t mLength{};
@@ -0,0 +1,56 @@
+#include "text/style.hpp"
+
+#define MASK(i) (1 << (i))
+
+StylePatch StylePatch::type(nchar::Type type, bool on) {
+    StylePatch patch;
+    if (!on) {
+        patch.clearTypes = MASK(type);
+        return patch;
+    }
+
+    patch.setTypes = MASK(type);
+    if (type == nchar::Subscript) patch.clearTypes = MASK(nchar::Superscript);
+    if (type == nchar::Superscript) patch.clearTypes = MASK(nchar::Subscript);
+    return patch;
+}
+
+bool StylePatch::sets(nchar::Type type) const {
+    return setTypes & MASK(type);
+}
+
+bool StylePatch::clears(nchar::Type type) const {
+    return clearTypes & MASK(type);
+}
+
+void StylePatch::apply(nchar& c) const {
+    int types = (c.getType() & ~clearTypes) | setTypes;
+    for (int type = 0; type < nchar::NumType; ++type) {
+        if ((types ^ c.getType()) & MASK(type)) {
+            c.toggleType(static_cast< nchar::Type >(type));
+        }
+    }
+
+    if (fontSize) c.setFontSize(*fontSize);
+    if (fontId) c.setFontId(*fontId);
+    if (color) c.setColor(*color);
+    if (backgroundColor) c.setBackgroundColor(*backgroundColor);
+    if (link) c.setLink(*link);
+}
+
+void StylePatch::apply(nstring& text) const {
+    for (std::size_t i = 0; i < text.length(); ++i) apply(text[i]);
+}
+
+StylePatch StylePatch::then(const StylePatch& later) const {
+    StylePatch patch = *this;
+    patch.setTypes = (setTypes & ~later.clearTypes) | later.setTypes;
+    patch.clearTypes = (clearTypes & ~later.setTypes) | later.clearTypes;
+
+    if (later.fontSize) patch.fontSize = later.fontSize;
+    if (later.fontId) patch.fontId = later.fontId;
+    if (later.color) patch.color = later.color;
+    if (later.backgroundColor) patch.backgroundColor = later.backgroundColor;
+    if (later.link) patch.link = later.link;
+    return patch;
+}
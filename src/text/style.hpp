@@ -0,0 +1,36 @@
+#ifndef TEXT_STYLE_HPP
+#define TEXT_STYLE_HPP
+
+#include <optional>
+#include <string>
+
+#include "text/nstring.hpp"
+
+// A change of attributes for a range of characters. Every attribute is either
+// left as it is or set to the same value on all of them; codepoints are never
+// touched.
+struct StylePatch {
+    // nchar::Type bits turned on and off
+    int setTypes{};
+    int clearTypes{};
+
+    std::optional< int > fontSize{};
+    std::optional< std::size_t > fontId{};
+    std::optional< Color > color{};
+    std::optional< Color > backgroundColor{};
+    std::optional< std::string > link{};
+
+    // Turns the type on or off, subscript and superscript exclude each other
+    static StylePatch type(nchar::Type type, bool on);
+
+    bool sets(nchar::Type type) const;
+    bool clears(nchar::Type type) const;
+
+    void apply(nchar& c) const;
+    void apply(nstring& text) const;
+
+    // This patch followed by `later`, as one patch
+    StylePatch then(const StylePatch& later) const;
+};
+
+#endif  // TEXT_STYLE_HPP
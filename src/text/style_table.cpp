@@ -0,0 +1,162 @@
+#include "text/style_table.hpp"
+
+#include <cstring>
+
+namespace {
+    template < typename T >
+    void put(std::string& out, T value) {
+        out.append(reinterpret_cast< const char* >(&value), sizeof(value));
+    }
+
+    void put(std::string& out, Color color) {
+        put(out, color.r);
+        put(out, color.g);
+        put(out, color.b);
+        put(out, color.a);
+    }
+
+    template < typename T >
+    std::uint32_t intern(std::unordered_map< T, std::uint32_t >& ids,
+                         std::vector< T >& values, const T& value) {
+        auto found = ids.find(value);
+        if (found != ids.end()) return found->second;
+
+        values.push_back(value);
+        return ids[value] = values.size() - 1;
+    }
+
+    // Bounds-checked reads, failing for good once one runs past the end
+    class Reader {
+    public:
+        Reader(const char* data, std::size_t size)
+            : mData{data}, mSize{size} {}
+
+        template < typename T >
+        T get() {
+            T value{};
+            if (const char* data = take(sizeof(T))) {
+                std::memcpy(&value, data, sizeof(T));
+            }
+            return value;
+        }
+
+        Color get_color() {
+            Color color{};
+            color.r = get< unsigned char >();
+            color.g = get< unsigned char >();
+            color.b = get< unsigned char >();
+            color.a = get< unsigned char >();
+            return color;
+        }
+
+        std::string get_string(std::size_t size) {
+            const char* data = take(size);
+            return data ? std::string(data, size) : std::string();
+        }
+
+        bool ok() const { return mOk; }
+        std::size_t position() const { return mPosition; }
+
+    private:
+        const char* take(std::size_t size) {
+            if (!mOk || size > mSize - mPosition) {
+                mOk = false;
+                return nullptr;
+            }
+            const char* data = mData + mPosition;
+            mPosition += size;
+            return data;
+        }
+
+        const char* mData{};
+        std::size_t mSize{};
+        std::size_t mPosition{0};
+        bool mOk{true};
+    };
+}  // namespace
+
+std::uint32_t StyleTable::add(const nchar& c) {
+    std::string record;
+    put(record, static_cast< std::uint8_t >(c.getType()));
+    put(record, static_cast< std::int32_t >(c.getFontSize()));
+    put(record, intern(mFontIds, mFonts,
+                       static_cast< std::uint64_t >(c.getFontId())));
+    put(record, c.getColor());
+    put(record, c.getBackgroundColor());
+    put(record, c.hasLink() ? intern(mLinkIds, mLinks, c.getLink()) + 1 : 0);
+
+    auto found = mStyleIds.find(record);
+    if (found != mStyleIds.end()) return found->second;
+
+    mStyles += record;
+    return mStyleIds[record] = mStyleCount++;
+}
+
+std::size_t StyleTable::size() const { return mStyleCount; }
+
+void StyleTable::write(std::string& out) const {
+    put(out, static_cast< std::uint32_t >(mLinks.size()));
+    for (const auto& link : mLinks) {
+        put(out, static_cast< std::uint32_t >(link.size()));
+        out += link;
+    }
+
+    put(out, static_cast< std::uint32_t >(mFonts.size()));
+    for (std::uint64_t font : mFonts) put(out, font);
+
+    put(out, mStyleCount);
+    out += mStyles;
+}
+
+std::size_t StyleTable::read(const char* data, std::size_t size,
+                             std::vector< nchar >& styles) {
+    Reader in(data, size);
+
+    // every count is checked against the bytes left before allocating
+    bool broken = false;
+    auto count = [&](std::size_t minimum) {
+        std::size_t value = in.get< std::uint32_t >();
+        if (value > (size - in.position()) / minimum) {
+            broken = true;
+            return std::size_t{0};
+        }
+        return value;
+    };
+
+    std::vector< std::string > links(count(4));
+    for (auto& link : links) {
+        link = in.get_string(in.get< std::uint32_t >());
+    }
+
+    std::vector< std::uint64_t > fonts(count(8));
+    for (auto& font : fonts) font = in.get< std::uint64_t >();
+
+    std::size_t styleCount = count(1 + 4 + 4 + 4 + 4 + 4);
+    styles.clear();
+    styles.reserve(styleCount);
+    for (std::size_t i = 0; i < styleCount && in.ok(); ++i) {
+        auto type = in.get< std::uint8_t >();
+        auto fontSize = in.get< std::int32_t >();
+        auto font = in.get< std::uint32_t >();
+        Color color = in.get_color();
+        Color background = in.get_color();
+        auto link = in.get< std::uint32_t >();
+        if (font >= fonts.size() || link > links.size()) return 0;
+
+        nchar style;
+        for (int bit = 0; bit < nchar::NumType; ++bit) {
+            if (type & (1 << bit)) {
+                style.toggleType(static_cast< nchar::Type >(bit));
+            }
+        }
+        style.setFontSize(fontSize);
+        style.setFontId(fonts[font]);
+        style.setColor(color);
+        style.setBackgroundColor(background);
+        if (link) style.setLink(links[link - 1]);
+
+        styles.push_back(std::move(style));
+    }
+
+    return in.ok() && !broken ? in.position() : 0;
+}
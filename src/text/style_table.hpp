@@ -0,0 +1,52 @@
+#ifndef TEXT_STYLE_TABLE_HPP
+#define TEXT_STYLE_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "text/nchar.hpp"
+
+/**
+ * @brief The distinct character styles of a text, each stored once.
+ * @details Styles are numbered in the order they are added, the links and
+ * font ids they refer to are kept in tables of their own. Files that store
+ * styled text write it as UTF-8 and runs of style numbers, with one table.
+ *
+ * Encoding, integers in native byte order:
+ *   u32 count, links as u32 size and bytes
+ *   u32 count, font ids as u64
+ *   u32 count, styles as u8 type, i32 font size, u32 font, rgba color,
+ *   rgba background, u32 link + 1 or 0
+ */
+class StyleTable {
+public:
+    // Number of the style of `c`, added if it is new
+    std::uint32_t add(const nchar& c);
+    std::size_t size() const;
+
+    // Appends the encoding to `out`
+    void write(std::string& out) const;
+
+    /**
+     * @brief Decode a table from `size` bytes at `data`.
+     * @param styles Gets a character per style, carrying its attributes.
+     * @return The bytes read, 0 if they are not a valid table.
+     */
+    static std::size_t read(const char* data, std::size_t size,
+                            std::vector< nchar >& styles);
+
+private:
+    std::unordered_map< std::string, std::uint32_t > mLinkIds{};
+    std::vector< std::string > mLinks{};
+    std::unordered_map< std::uint64_t, std::uint32_t > mFontIds{};
+    std::vector< std::uint64_t > mFonts{};
+
+    // style records as written, keyed by their bytes
+    std::unordered_map< std::string, std::uint32_t > mStyleIds{};
+    std::string mStyles{};
+    std::uint32_t mStyleCount{0};
+};
+
+#endif  // TEXT_STYLE_TABLE_HPP
@@ -0,0 +1,25 @@
+#include "text/utf8.hpp"
+
+namespace utf8 {
+
+    void append(std::string& out, int codepoint) {
+        if (codepoint < 0 || codepoint > 0x10FFFF) codepoint = replacement;
+
+        if (codepoint < 0x80) {
+            out += static_cast< char >(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast< char >(0xC0 | (codepoint >> 6));
+            out += static_cast< char >(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast< char >(0xE0 | (codepoint >> 12));
+            out += static_cast< char >(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast< char >(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast< char >(0xF0 | (codepoint >> 18));
+            out += static_cast< char >(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast< char >(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast< char >(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+}  // namespace utf8
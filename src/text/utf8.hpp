@@ -0,0 +1,125 @@
+#ifndef TEXT_UTF8_HPP
+#define TEXT_UTF8_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace utf8 {
+    constexpr int replacement = 0xFFFD;
+
+    /**
+     * @brief Incremental UTF-8 decoder.
+     * @details Input can be fed in blocks of any size, a sequence split
+     * between two blocks is completed by the next feed(). Malformed input
+     * (stray continuation bytes, truncated or overlong sequences, surrogates)
+     * decodes to U+FFFD instead of being dropped.
+     */
+    class Decoder {
+    public:
+        // Calls sink(int codepoint) for every complete codepoint in the block
+        template < typename Sink >
+        void feed(const char* data, std::size_t size, Sink&& sink);
+
+        // Ends the input, a pending incomplete sequence becomes U+FFFD
+        template < typename Sink >
+        void finish(Sink&& sink);
+
+    private:
+        int mCodepoint{0};
+        int mNeeded{0};
+        int mMinimum{0};
+    };
+
+    /**
+     * @brief Decoder for text files: "\r\n" and a lone '\r' both become '\n'.
+     */
+    class TextDecoder {
+    public:
+        template < typename Sink >
+        void feed(const char* data, std::size_t size, Sink&& sink);
+
+        template < typename Sink >
+        void finish(Sink&& sink);
+
+    private:
+        template < typename Sink >
+        void push(int codepoint, Sink& sink);
+
+        Decoder mDecoder{};
+        bool mCarriageReturn{false};
+    };
+
+    // Appends the UTF-8 encoding of codepoint to out
+    void append(std::string& out, int codepoint);
+
+    template < typename Sink >
+    void Decoder::feed(const char* data, std::size_t size, Sink&& sink) {
+        for (std::size_t i = 0; i < size; ++i) {
+            auto byte = static_cast< std::uint8_t >(data[i]);
+
+            if (mNeeded) {
+                if ((byte & 0xC0) == 0x80) {
+                    mCodepoint = (mCodepoint << 6) | (byte & 0x3F);
+                    if (--mNeeded == 0) {
+                        bool surrogate =
+                            mCodepoint >= 0xD800 && mCodepoint <= 0xDFFF;
+                        bool valid = mCodepoint >= mMinimum &&
+                                     mCodepoint <= 0x10FFFF && !surrogate;
+                        sink(valid ? mCodepoint : replacement);
+                    }
+                    continue;
+                }
+
+                // the sequence ended early, this byte starts a new one
+                mNeeded = 0;
+                sink(replacement);
+            }
+
+            if (byte < 0x80) {
+                sink(static_cast< int >(byte));
+            } else if ((byte & 0xE0) == 0xC0) {
+                mCodepoint = byte & 0x1F;
+                mNeeded = 1;
+                mMinimum = 0x80;
+            } else if ((byte & 0xF0) == 0xE0) {
+                mCodepoint = byte & 0x0F;
+                mNeeded = 2;
+                mMinimum = 0x800;
+            } else if ((byte & 0xF8) == 0xF0) {
+                mCodepoint = byte & 0x07;
+                mNeeded = 3;
+                mMinimum = 0x10000;
+            } else {
+                sink(replacement);
+            }
+        }
+    }
+
+    template < typename Sink >
+    void Decoder::finish(Sink&& sink) {
+        if (mNeeded) sink(replacement);
+        mNeeded = 0;
+    }
+
+    template < typename Sink >
+    void TextDecoder::feed(const char* data, std::size_t size, Sink&& sink) {
+        mDecoder.feed(data, size,
+                      [&](int codepoint) { push(codepoint, sink); });
+    }
+
+    template < typename Sink >
+    void TextDecoder::finish(Sink&& sink) {
+        mDecoder.finish([&](int codepoint) { push(codepoint, sink); });
+        if (mCarriageReturn) sink('\n');
+        mCarriageReturn = false;
+    }
+
+    template < typename Sink >
+    void TextDecoder::push(int codepoint, Sink& sink) {
+        if (mCarriageReturn && codepoint != '\n') sink('\n');
+        mCarriageReturn = codepoint == '\r';
+        if (!mCarriageReturn) sink(codepoint);
+    }
+}  // namespace utf8
+
+#endif  // TEXT_UTF8_HPP
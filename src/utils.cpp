@@ -66,6 +66,19 @@ namespace utils {
         system(command.c_str());
     }
 
+    void DrawSquiggle(Vector2 start, float width, Color color) {
+        constexpr float step = 3.0f;
+        constexpr float amplitude = 1.5f;
+
+        Vector2 prev = start;
+        for (float x = step; x <= width; x += step) {
+            Vector2 next{start.x + x,
+                         start.y + (prev.y == start.y ? amplitude : 0.0f)};
+            DrawLineEx(prev, next, 1.0f, color);
+            prev = next;
+        }
+    }
+
     // Draw text using font inside rectangle limits
     void DrawTextBoxed(Font font, const char* text, Rectangle rec,
                        float fontSize, float spacing, bool wordWrap,
@@ -18,6 +18,9 @@ namespace utils {
 
     void open_link(nstring link);
 
+    // Draw a wavy underline, used to mark misspelled words
+    void DrawSquiggle(Vector2 start, float width, Color color);
+
     // Draw text using font inside rectangle limits
     void DrawTextBoxed(Font font, const char* text, Rectangle rec,
                        float fontSize, float spacing, bool wordWrap,